@@ -0,0 +1,34 @@
+TEMPLATE = app
+TARGET = bench_repo
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG -= qt
+
+CONFIG += c++11 thread
+QMAKE_CXXFLAGS += -std=c++11
+
+SOURCES += bench_repo.cpp \
+    ../tokenizer.cpp \
+    ../parser.cpp \
+    ../validator.cpp \
+    ../loader.cpp \
+    ../trace.cpp \
+    ../diff.cpp \
+    ../lines.cpp \
+    ../perf.cpp \
+    ../extract.cpp \
+    ../json.cpp \
+    ../number.cpp
+
+HEADERS += \
+    ../tokenizer.h \
+    ../parser.h \
+    ../validator.h \
+    ../loader.h \
+    ../trace.h \
+    ../diff.h \
+    ../lines.h \
+    ../perf.h \
+    ../extract.h \
+    ../json.h \
+    ../number.h
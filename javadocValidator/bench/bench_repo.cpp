@@ -0,0 +1,365 @@
+/**
+  * @author Team A
+  * @file bench_repo.cpp
+  *
+  * @brief benchmark of validation over generated repository
+  *
+  * generates tree of files with many small and a few huge files, then
+  * validates it the same way as main (FileLoader + validate) with cold and
+  * warm page cache and writes files/sec, MB/s, per-file latency
+  * percentiles and peak RSS as JSON, which can be diffed between versions
+  */
+#include "../validator.h"
+#include "../loader.h"
+#include "../number.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+namespace {
+
+struct Settings {
+    unsigned files = 10000;
+    unsigned seed = 1;
+    string directory = "bench_tree";
+    string output;
+    bool keep = false;
+    ValidationOptions options;
+};
+
+struct Result {
+    double seconds;
+    double p50;
+    double p99;
+    double max;
+    long peakRssKb;
+    unsigned valid;
+    bool evicted;
+};
+
+/* size distribution, median is about 3 KB, every 1000th file is huge */
+const double sizeLogMean = 8.0;
+const double sizeLogDeviation = 1.2;
+const unsigned hugeEvery = 1000;
+const size_t hugeMin = 1 << 20;
+const size_t hugeMax = 8 << 20;
+const unsigned filesPerDirectory = 100;
+
+void printUsage(const char *program)
+{
+    cout << "Usage: " << program << " [options]" << endl
+         << "Options:" << endl
+         << "  --files N         number of generated files, at least 1 (default 10000)" << endl
+         << "  --seed N          seed of generated tree (default 1)" << endl
+         << "  --dir directory   where the tree is generated (default bench_tree)" << endl
+         << "  --output file     write JSON to file instead of standard output" << endl
+         << "  --keep            keep existing tree with the same files and seed" << endl
+         << "  --lazy            validate with --lazy" << endl
+         << "  --prefilter       validate with --prefilter" << endl
+         << "  --all-errors      validate with --all-errors" << endl;
+}
+
+string makeFunction(mt19937 &random, unsigned index)
+{
+    ostringstream function;
+    unsigned params = random() % 5;
+
+    function << "/**\n * @brief function" << index << " does some work\n";
+    for (unsigned i = 0; i < params; ++i)
+        function << " * @param arg" << i << " argument number " << i << "\n";
+    function << " * @return result of work\n */\n"
+             << "int function" << index << "(";
+    for (unsigned i = 0; i < params; ++i)
+        function << (i > 0 ? ", " : "") << (i % 2 ? "const char *arg" : "int arg") << i;
+    function << ")\n{\n";
+
+    unsigned lines = 3 + random() % 20;
+    for (unsigned i = 0; i < lines; ++i)
+        function << "    value = value * 31 + " << random() % 1000
+                 << "; // \"mixing\" step\n";
+    function << "    return value;\n}\n\n";
+    return function.str();
+}
+
+string makeFile(mt19937 &random, const string &fileName, size_t size)
+{
+    string content;
+    content.reserve(size + 1024);
+
+    //every fifth file has no doxygen, so --prefilter is measured too
+    bool documented = random() % 5 != 0;
+    if (documented)
+        content += "/**\n * @author Bench\n * @file " + fileName
+                + "\n * @brief generated file\n */\n";
+    content += "#include <stdio.h>\n\nstatic int value;\n\n";
+
+    unsigned index = 0;
+    while (content.size() < size) {
+        string function = makeFunction(random, index++);
+        if (!documented)
+            function.erase(0, function.find("*/\n") + 3);
+        content += function;
+    }
+    return content;
+}
+
+bool generateTree(const Settings &settings, vector< string > &paths, size_t &bytes)
+{
+    mt19937 random(settings.seed);
+    lognormal_distribution< double > smallSize(sizeLogMean, sizeLogDeviation);
+    uniform_int_distribution< size_t > hugeSize(hugeMin, hugeMax);
+
+    if (mkdir(settings.directory.c_str(), 0755) < 0 && errno != EEXIST)
+        return false;
+
+    //the same seed generates the same tree, so --keep can reuse it
+    string stamp = settings.directory + "/.bench";
+    ostringstream expected;
+    expected << settings.files << " " << settings.seed << "\n";
+    bool reuse = false;
+    if (settings.keep) {
+        ifstream in(stamp);
+        string line;
+        reuse = getline(in, line) && line + "\n" == expected.str();
+    }
+
+    bytes = 0;
+    for (unsigned i = 0; i < settings.files; ++i) {
+        ostringstream directory;
+        directory << "dir" << i / filesPerDirectory;
+        ostringstream path;
+        path << directory.str() << "/file" << i << ".c";
+        paths.push_back(path.str());
+
+        size_t size = (i % hugeEvery == hugeEvery - 1)
+                ? hugeSize(random)
+                : static_cast< size_t >(smallSize(random));
+        string content = makeFile(random, paths.back(), size);
+        bytes += content.size();
+        if (reuse)
+            continue;
+
+        if (i % filesPerDirectory == 0)
+            mkdir((settings.directory + "/" + directory.str()).c_str(), 0755);
+        ofstream out(settings.directory + "/" + paths.back(), ios::binary);
+        out << content;
+        if (!out.good())
+            return false;
+    }
+
+    ofstream(stamp) << expected.str();
+    return true;
+}
+
+bool evictFiles(const vector< string > &paths)
+{
+    //posix_fadvise doesn't need root, unlike /proc/sys/vm/drop_caches
+    sync();
+    bool evicted = true;
+    for (auto &path : paths) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0 || posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) != 0)
+            evicted = false;
+        if (fd >= 0)
+            close(fd);
+    }
+    return evicted;
+}
+
+double percentile(const vector< double > &sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0;
+    return sorted[static_cast< size_t >(fraction * (sorted.size() - 1) + 0.5)];
+}
+
+Result runValidation(const vector< string > &paths, const ValidationOptions &options)
+{
+    Result result = Result();
+    vector< double > latencies;
+    latencies.reserve(paths.size());
+    ostream out(nullptr);
+
+    auto begin = chrono::steady_clock::now();
+    auto last = begin;
+    FileLoader loader(paths);
+    FileLoader::File file;
+    while (loader.next(file)) {
+        if (file.loaded && validate(file.content, file.path, options, out))
+            ++result.valid;
+        loader.release(file);
+
+        //files are loaded ahead, so latency is time between finished files
+        auto now = chrono::steady_clock::now();
+        latencies.push_back(chrono::duration< double, milli >(now - last).count());
+        last = now;
+    }
+    result.seconds = chrono::duration< double >(last - begin).count();
+
+    sort(latencies.begin(), latencies.end());
+    result.p50 = percentile(latencies, 0.50);
+    result.p99 = percentile(latencies, 0.99);
+    result.max = latencies.empty() ? 0 : latencies.back();
+    return result;
+}
+
+bool runPhase(const vector< string > &paths, const ValidationOptions &options,
+              bool cold, Result &result)
+{
+    bool evicted = cold && evictFiles(paths);
+
+    //own process, so peak RSS belongs to this phase only
+    int pipeFds[2];
+    if (pipe(pipeFds) < 0)
+        return false;
+
+    pid_t pid = fork();
+    if (pid < 0)
+        return false;
+    if (pid == 0) {
+        close(pipeFds[0]);
+        Result childResult = runValidation(paths, options);
+        ssize_t written = write(pipeFds[1], &childResult, sizeof(childResult));
+        _exit(written == sizeof(childResult) ? 0 : 1);
+    }
+
+    close(pipeFds[1]);
+    ssize_t got = read(pipeFds[0], &result, sizeof(result));
+    close(pipeFds[0]);
+
+    int status;
+    rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0 || got != sizeof(result)
+        || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return false;
+
+    result.peakRssKb = usage.ru_maxrss;
+    result.evicted = evicted;
+    return true;
+}
+
+void writePhase(ostream &out, const char *name, const Result &result,
+                size_t files, size_t bytes, bool last)
+{
+    //phase below clock resolution has no rate, JSON has no nan
+    double perSecond = result.seconds > 0 ? 1 / result.seconds : 0;
+    out << "    \"" << name << "\": {\n"
+        << "      \"seconds\": " << result.seconds << ",\n"
+        << "      \"files_per_sec\": " << files * perSecond << ",\n"
+        << "      \"mb_per_sec\": " << bytes / 1e6 * perSecond << ",\n"
+        << "      \"latency_ms_p50\": " << result.p50 << ",\n"
+        << "      \"latency_ms_p99\": " << result.p99 << ",\n"
+        << "      \"latency_ms_max\": " << result.max << ",\n"
+        << "      \"peak_rss_kb\": " << result.peakRssKb << ",\n"
+        << "      \"valid_files\": " << result.valid << ",\n"
+        << "      \"cache_evicted\": " << (result.evicted ? "true" : "false") << "\n"
+        << "    }" << (last ? "\n" : ",\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Settings settings;
+    for (int i = 1; i < argc; ++i) {
+        string arg(argv[i]);
+        if (arg == "--files" && i + 1 < argc) {
+            //rates of empty tree would divide by zero
+            if (!parseCount(argv[++i], settings.files) || settings.files == 0) {
+                cerr << "Invalid number of files " << argv[i] << endl;
+                printUsage(argv[0]);
+                return -1;
+            }
+        }
+        else if (arg == "--seed" && i + 1 < argc) {
+            if (!parseCount(argv[++i], settings.seed)) {
+                cerr << "Invalid seed " << argv[i] << endl;
+                printUsage(argv[0]);
+                return -1;
+            }
+        }
+        else if (arg == "--dir" && i + 1 < argc)
+            settings.directory = argv[++i];
+        else if (arg == "--output" && i + 1 < argc)
+            settings.output = argv[++i];
+        else if (arg == "--keep")
+            settings.keep = true;
+        else if (arg == "--lazy")
+            settings.options.lazy = true;
+        else if (arg == "--prefilter")
+            settings.options.prefilter = true;
+        else if (arg == "--all-errors")
+            settings.options.collectAll = true;
+        else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    //relative path of output is relative to working directory, not to the tree
+    ofstream file;
+    if (!settings.output.empty()) {
+        file.open(settings.output);
+        if (!file.is_open()) {
+            cerr << "output could not be written to " << settings.output << endl;
+            return -1;
+        }
+    }
+
+    vector< string > paths;
+    size_t bytes;
+    cerr << "generating " << settings.files << " files in " << settings.directory << endl;
+    if (!generateTree(settings, paths, bytes)) {
+        cerr << "tree could not be generated in " << settings.directory << endl;
+        return -1;
+    }
+
+    //paths are relative to the tree, so they match @file
+    if (chdir(settings.directory.c_str()) < 0)
+        return -1;
+
+    Result cold;
+    Result warm;
+    cerr << "validating with cold cache" << endl;
+    if (!runPhase(paths, settings.options, true, cold))
+        return -1;
+    cerr << "validating with warm cache" << endl;
+    if (!runPhase(paths, settings.options, false, warm))
+        return -1;
+
+    ostream &out = settings.output.empty() ? cout : file;
+    out.setf(ios_base::fixed);
+    out.precision(3);
+
+    //one value per line, so results of two versions can be diffed
+    out << "{\n"
+        << "  \"files\": " << paths.size() << ",\n"
+        << "  \"bytes\": " << bytes << ",\n"
+        << "  \"seed\": " << settings.seed << ",\n"
+        << "  \"lazy\": " << (settings.options.lazy ? "true" : "false") << ",\n"
+        << "  \"prefilter\": " << (settings.options.prefilter ? "true" : "false") << ",\n"
+        << "  \"all_errors\": " << (settings.options.collectAll ? "true" : "false") << ",\n"
+        << "  \"runs\": {\n";
+    writePhase(out, "cold", cold, paths.size(), bytes, false);
+    writePhase(out, "warm", warm, paths.size(), bytes, true);
+    out << "  }\n}\n";
+    return out.good() ? 0 : -1;
+}
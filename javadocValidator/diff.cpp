@@ -0,0 +1,131 @@
+#include "diff.h"
+
+#include <algorithm>
+#include <fstream>
+#include <cstdlib>
+
+bool DiffIndex::load(const std::string &path)
+{
+    if (path == "-") {
+        parse(std::cin);
+        return true;
+    }
+
+    std::ifstream input(path);
+    if (!input.is_open())
+        return false;
+
+    parse(input);
+    return true;
+}
+
+void DiffIndex::parse(std::istream &input)
+{
+    std::string line;
+    LineRanges *current = nullptr;
+    unsigned oldLeft = 0;
+    unsigned newLeft = 0;
+    unsigned newLine = 0;
+
+    while (std::getline(input, line)) {
+        //inside of hunk, lines are counted, so "--- " can be deleted line
+        if (oldLeft > 0 || newLeft > 0) {
+            char kind = line.empty() ? ' ' : line[0];
+            if (kind == '\\') //"\ No newline at end of file"
+                continue;
+            if (kind != '+' && oldLeft > 0)
+                --oldLeft;
+            if (kind != '-' && newLeft > 0)
+                --newLeft;
+
+            //deleted line changes the unit around it
+            if (kind != ' ' && current != nullptr) {
+                unsigned changed = std::max(newLine, 1u);
+                current->push_back(std::make_pair(changed, changed));
+            }
+            if (kind != '-')
+                ++newLine;
+            continue;
+        }
+
+        if (line.compare(0, 4, "+++ ") == 0) {
+            std::string path = line.substr(4);
+            auto tab = path.find('\t'); //timestamp of diff -u
+            if (tab != std::string::npos)
+                path.erase(tab);
+
+            if (path == "/dev/null") {
+                current = nullptr;
+                continue;
+            }
+            if (path.compare(0, 2, "b/") == 0)
+                path.erase(0, 2);
+            current = &files[path];
+        }
+        else if (line.compare(0, 4, "@@ -") == 0) {
+            unsigned oldCount, newStart, newCount;
+            if (!parseHunkHeader(line, oldCount, newStart, newCount))
+                continue;
+
+            oldLeft = oldCount;
+            newLeft = newCount;
+            newLine = newStart;
+        }
+    }
+
+    //hunks of the same file can be in diff more times
+    for (auto &file : files) {
+        LineRanges &ranges = file.second;
+        std::sort(ranges.begin(), ranges.end());
+
+        LineRanges merged;
+        for (auto &range : ranges) {
+            if (!merged.empty() && range.first <= merged.back().second + 1)
+                merged.back().second = std::max(merged.back().second, range.second);
+            else
+                merged.push_back(range);
+        }
+        ranges.swap(merged);
+    }
+}
+
+bool DiffIndex::parseHunkHeader(const std::string &line, unsigned &oldCount,
+                                unsigned &newStart, unsigned &newCount)
+{
+    //"@@ -oldStart[,oldCount] +newStart[,newCount] @@", counts are 1 if missing
+    const char *pos = line.c_str() + 4;
+    char *end;
+
+    std::strtoul(pos, &end, 10);
+    oldCount = 1;
+    if (*end == ',')
+        oldCount = std::strtoul(end + 1, &end, 10);
+
+    if (end[0] != ' ' || end[1] != '+')
+        return false;
+
+    newStart = std::strtoul(end + 2, &end, 10);
+    newCount = 1;
+    if (*end == ',')
+        newCount = std::strtoul(end + 1, &end, 10);
+
+    return *end == ' ';
+}
+
+const LineRanges *DiffIndex::find(const std::string &path) const
+{
+    auto it = files.find(path);
+    if (it != files.end())
+        return &it->second;
+
+    auto endsWith = [](const std::string &text, const std::string &suffix) {
+        return text.size() > suffix.size()
+                && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0
+                && text[text.size() - suffix.size() - 1] == '/';
+    };
+
+    for (auto &file : files)
+        if (endsWith(file.first, path) || endsWith(path, file.first))
+            return &file.second;
+    return nullptr;
+}
@@ -0,0 +1,61 @@
+/**
+  * @author Team A
+  * @file diff.h
+  *
+  * @brief class DiffIndex maps files of unified diff to their changed lines
+  */
+#ifndef DIFF_H
+#define DIFF_H
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "lines.h"
+
+class DiffIndex
+{
+public:
+    /**
+     * @brief load reads unified diff (e.g. output of git diff)
+     * @param path path of diff file, "-" for standard input
+     * @return false if file could not be read
+     */
+    bool load(const std::string &path);
+    /**
+     * @brief parse reads unified diff from stream
+     *
+     * added lines and lines, where something was deleted, are
+     * stored as changed lines of new version of the file
+     *
+     * @param input stream with diff
+     */
+    void parse(std::istream &input);
+
+    /**
+     * @brief find returns changed lines of file
+     *
+     * paths match, if they are equal or one of them ends with
+     * "/" followed by the other one
+     *
+     * @param path path of file as given on command line
+     * @return changed lines or nullptr, if file is not in diff
+     */
+    const LineRanges *find(const std::string &path) const;
+
+private:
+    std::map< std::string, LineRanges > files;
+
+    /**
+     * @brief parseHunkHeader reads line numbers from "@@ -a,b +c,d @@" line
+     * @param line header of hunk
+     * @param oldCount number of lines of hunk in old version
+     * @param newStart first line of hunk in new version
+     * @param newCount number of lines of hunk in new version
+     * @return false if line is not valid header of hunk
+     */
+    static bool parseHunkHeader(const std::string &line, unsigned &oldCount,
+                                unsigned &newStart, unsigned &newCount);
+};
+
+#endif // DIFF_H
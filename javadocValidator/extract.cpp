@@ -0,0 +1,65 @@
+#include "extract.h"
+#include "json.h"
+
+#include <algorithm>
+
+namespace {
+
+void writeOffsets(std::ostream &out, const DocFunction::Offsets &offsets)
+{
+    out << '[' << offsets.first << ',' << offsets.second << ']';
+}
+
+} // namespace
+
+std::string cleanDocText(const std::string &code, std::string::size_type begin,
+                         std::string::size_type end)
+{
+    std::string text;
+    end = std::min(end, code.size());
+
+    while (begin < end) {
+        auto lineEnd = code.find('\n', begin);
+        if (lineEnd == std::string::npos || lineEnd > end)
+            lineEnd = end;
+
+        //comment decoration of line
+        auto first = code.find_first_not_of(" \t\r*", begin);
+        auto last = code.find_last_not_of(" \t\r", lineEnd - 1);
+        if (first < lineEnd && last != std::string::npos && last >= first) {
+            if (!text.empty())
+                text += ' ';
+            text.append(code, first, last + 1 - first);
+        }
+        begin = lineEnd + 1;
+    }
+    return text;
+}
+
+void writeDocFunctions(std::ostream &out, const std::string &fileName,
+                       const std::vector< DocFunction > &functions)
+{
+    for (auto &function : functions) {
+        out << "{\"file\":";
+        writeJsonString(out, fileName);
+        out << ",\"function\":";
+        writeJsonString(out, function.name);
+        out << ",\"brief\":";
+        writeJsonString(out, function.brief);
+        out << ",\"params\":[";
+        for (std::size_t i = 0; i < function.params.size(); ++i) {
+            out << (i > 0 ? ",{\"name\":" : "{\"name\":");
+            writeJsonString(out, function.params[i].name);
+            out << ",\"description\":";
+            writeJsonString(out, function.params[i].description);
+            out << '}';
+        }
+        out << "],\"return\":";
+        writeJsonString(out, function.returnText);
+        out << ",\"comment\":";
+        writeOffsets(out, function.comment);
+        out << ",\"signature\":";
+        writeOffsets(out, function.signature);
+        out << ",\"valid\":" << (function.valid ? "true" : "false") << "}\n";
+    }
+}
@@ -0,0 +1,70 @@
+/**
+  * @author Team A
+  * @file extract.h
+  *
+  * @brief documentation model of functions, collected by Parser during validation
+  */
+#ifndef EXTRACT_H
+#define EXTRACT_H
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief DocParam documented argument of function
+ */
+struct DocParam {
+    std::string name;
+    std::string description;
+};
+
+/**
+ * @brief DocFunction doxygen comment and signature of one function
+ */
+struct DocFunction {
+    /**
+     * @brief Offsets [begin, end) positions in file
+     */
+    typedef std::pair< std::string::size_type, std::string::size_type > Offsets;
+
+    std::string name;
+    std::string brief;
+    std::vector< DocParam > params;
+    std::string returnText;
+    Offsets comment;
+    /**
+     * @brief signature from function name to ')' after arguments
+     */
+    Offsets signature;
+    /**
+     * @brief valid false if function has error (with --all-errors)
+     *
+     * recovery skips rest of comment with error, so its function is not extracted
+     */
+    bool valid;
+};
+
+/**
+ * @brief cleanDocText makes text of command from part of comment
+ *
+ * leading whitespace and '*' of lines are removed, lines are joined by space
+ *
+ * @param code code of file
+ * @param begin first position of text
+ * @param end position after text
+ * @return text of the command
+ */
+std::string cleanDocText(const std::string &code, std::string::size_type begin,
+                         std::string::size_type end);
+
+/**
+ * @brief writeDocFunctions writes functions of file as JSON Lines, object per function
+ * @param out output stream
+ * @param fileName name of the file
+ * @param functions documented functions of the file
+ */
+void writeDocFunctions(std::ostream &out, const std::string &fileName,
+                       const std::vector< DocFunction > &functions);
+
+#endif // EXTRACT_H
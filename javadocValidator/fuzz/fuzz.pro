@@ -0,0 +1,45 @@
+TEMPLATE = app
+TARGET = validator_fuzzer
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG -= qt
+
+CONFIG += c++11 thread
+QMAKE_CXXFLAGS += -std=c++11
+
+# CONFIG+=replay builds plain binary, which only runs given inputs
+replay {
+    DEFINES += FUZZ_REPLAY
+} else {
+    QMAKE_CC = clang
+    QMAKE_CXX = clang++
+    QMAKE_LINK = clang++
+    QMAKE_CXXFLAGS += -g -fsanitize=fuzzer,address,undefined
+    QMAKE_LFLAGS += -fsanitize=fuzzer,address,undefined
+}
+
+SOURCES += fuzz_validator.cpp \
+    ../tokenizer.cpp \
+    ../parser.cpp \
+    ../validator.cpp \
+    ../trace.cpp \
+    ../diff.cpp \
+    ../lines.cpp \
+    ../perf.cpp \
+    ../extract.cpp \
+    ../json.cpp
+
+HEADERS += \
+    ../tokenizer.h \
+    ../parser.h \
+    ../validator.h \
+    ../trace.h \
+    ../diff.h \
+    ../lines.h \
+    ../perf.h \
+    ../extract.h \
+    ../json.h
+
+OTHER_FILES += \
+    make_corpus.sh \
+    run_fuzz.sh
@@ -0,0 +1,97 @@
+/**
+  * @author Team A
+  * @file fuzz_validator.cpp
+  *
+  * @brief libFuzzer target of validation with time budget
+  *
+  * first byte of input selects validation options, second byte turns off
+  * rules, the rest is validated as file input.c
+  *
+  * input, which runs longer than its budget, is reported as crash, so
+  * performance cliffs are found together with memory errors, memory is
+  * limited by -malloc_limit_mb and -rss_limit_mb of libFuzzer (see run_fuzz.sh)
+  *
+  * built with FUZZ_REPLAY, the target has its own main, which runs given
+  * files (e.g. regressions/) without libFuzzer
+  */
+#include "../validator.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace {
+
+/* budget is generous, so only cliffs are reported, not noise */
+const double timeBudgetBaseMs = 50.0;
+const double timeBudgetPerKbMs = 5.0;
+
+ValidationOptions getOptions(std::uint8_t flags, std::uint8_t rulesOff)
+{
+    ValidationOptions options;
+    options.lazy = flags & 1;
+    options.prefilter = flags & 2;
+    options.collectAll = flags & 4;
+    options.maxErrors = (flags & 8) ? 0 : 100;
+    //bits of Rule, so every rule set can be turned on
+    options.rules = allRules & ~static_cast< unsigned >(rulesOff);
+    return options;
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t *data, std::size_t size)
+{
+    if (size < 2)
+        return 0;
+
+    ValidationOptions options = getOptions(data[0], data[1]);
+    std::string input(reinterpret_cast< const char * >(data) + 2, size - 2);
+
+    //diagnostics and extracted model are not needed, stream without buffer drops them
+    std::ostream out(nullptr);
+    options.extract = &out;
+
+    auto begin = std::chrono::steady_clock::now();
+
+    validate(input, "input.c", options, out);
+
+    double elapsedMs = std::chrono::duration< double, std::milli >
+            (std::chrono::steady_clock::now() - begin).count();
+
+    double timeBudget = timeBudgetBaseMs + timeBudgetPerKbMs * (size / 1024.0);
+    if (elapsedMs > timeBudget) {
+        std::fprintf(stderr, "==fuzz== time budget exceeded: %.1f ms for %zu bytes"
+                     " (budget %.1f ms)\n", elapsedMs, size, timeBudget);
+        std::abort();
+    }
+
+    return 0;
+}
+
+#ifdef FUZZ_REPLAY
+#include <fstream>
+#include <iterator>
+
+int main(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file.is_open()) {
+            std::fprintf(stderr, "could not open %s\n", argv[i]);
+            return -1;
+        }
+
+        std::string data((std::istreambuf_iterator< char >(file)),
+                         std::istreambuf_iterator< char >());
+        std::fprintf(stderr, "running %s\n", argv[i]);
+        LLVMFuzzerTestOneInput(reinterpret_cast< const std::uint8_t * >(data.data()),
+                               data.size());
+    }
+    return 0;
+}
+#endif
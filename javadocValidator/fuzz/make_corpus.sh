@@ -0,0 +1,24 @@
+#!/bin/sh
+# creates seed corpus from input.c
+# first byte of each seed selects validation options, second byte turns off
+# rules, see fuzz_validator.cpp
+cd "$(dirname "$0")" || exit 1
+mkdir -p corpus
+
+octal() {
+    printf "\\$(printf '%03o' "$1")"
+}
+
+flags=0
+while [ $flags -lt 16 ]; do
+    rules=0
+    while [ $rules -lt 32 ]; do
+        { octal $flags; octal $rules; cat ../../input.c; } > corpus/input-$flags-$rules
+        rules=$((rules + 1))
+    done
+    flags=$((flags + 1))
+done
+
+# header and documented function alone
+{ printf '\000\000'; sed -n '1,/\*\//p' ../../input.c; } > corpus/header
+{ printf '\000\000'; awk 'n >= 2 { print } /^\/\*\*/ { n++; if (n == 2) print }' ../../input.c; } > corpus/function
@@ -0,0 +1,36 @@
+#!/bin/sh
+# replays regressions, runs fuzzer on seed corpus and saves minimized findings
+# to regressions/ as <kind>-<sha1 of content>, same as libFuzzer names them
+#   usage: run_fuzz.sh [libFuzzer options], e.g. run_fuzz.sh -max_total_time=600
+cd "$(dirname "$0")" || exit 1
+FUZZER=${FUZZER:-./validator_fuzzer}
+
+# time per KB is checked by fuzz_validator.cpp, libFuzzer reports
+# allocation over -malloc_limit_mb, runaway memory and hangs
+LIMITS="-max_len=65536 -timeout=10 -malloc_limit_mb=64 -rss_limit_mb=1024"
+
+[ -d corpus ] || sh make_corpus.sh
+mkdir -p findings regressions
+
+# name of regression has to match its content, damaged file would pass unnoticed
+for regression in regressions/*; do
+    [ -f "$regression" ] || continue
+    name=$(basename "$regression")
+    if [ "${name##*-}" != "$(sha1sum < "$regression" | cut -c1-40)" ]; then
+        echo "$regression doesn't match its name" >&2
+        exit 1
+    fi
+    "$FUZZER" $LIMITS "$regression" || exit 1
+done
+
+"$FUZZER" $LIMITS -artifact_prefix=findings/ "$@" corpus
+
+for finding in findings/crash-* findings/timeout-* findings/oom-* findings/leak-*; do
+    [ -f "$finding" ] || continue
+    kind=$(basename "$finding" | cut -d- -f1)
+    "$FUZZER" -minimize_crash=1 -runs=20000 $LIMITS \
+        -exact_artifact_path=findings/minimized "$finding"
+    [ -f findings/minimized ] || cp "$finding" findings/minimized
+    mv findings/minimized "regressions/$kind-$(sha1sum < findings/minimized | cut -c1-40)"
+    rm "$finding"
+done
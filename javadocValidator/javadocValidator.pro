@@ -3,16 +3,39 @@ CONFIG += console
 CONFIG -= app_bundle
 CONFIG -= qt
 
-CONFIG += c++11
+CONFIG += c++11 thread
 QMAKE_CXXFLAGS += -std=c++11
 
 SOURCES += main.cpp \
     tokenizer.cpp \
-    parser.cpp
+    parser.cpp \
+    validator.cpp \
+    watcher.cpp \
+    loader.cpp \
+    trace.cpp \
+    diff.cpp \
+    lines.cpp \
+    shard.cpp \
+    perf.cpp \
+    extract.cpp \
+    json.cpp \
+    number.cpp
 
 HEADERS += \
     tokenizer.h \
-    parser.h
+    parser.h \
+    validator.h \
+    watcher.h \
+    loader.h \
+    trace.h \
+    diff.h \
+    lines.h \
+    shard.h \
+    perf.h \
+    extract.h \
+    json.h \
+    number.h
 
 OTHER_FILES +=  \
-    ../input.c
+    ../input.c \
+    tests/pipe_input.sh
@@ -0,0 +1,22 @@
+#include "json.h"
+
+#include <cstdio>
+
+void writeJsonString(std::ostream &out, const std::string &text)
+{
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        }
+        else if (static_cast< unsigned char >(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        }
+        else {
+            out << c;
+        }
+    }
+    out << '"';
+}
@@ -0,0 +1,23 @@
+/**
+  * @author Team A
+  * @file json.h
+  *
+  * @brief helpers for JSON output of trace and extracted documentation
+  */
+#ifndef JSON_H
+#define JSON_H
+#include <ostream>
+#include <string>
+
+/**
+ * @brief writeJsonString writes text as quoted JSON string
+ *
+ * quotes, backslashes and control characters are escaped, other bytes
+ * are written as they are
+ *
+ * @param out output stream
+ * @param text text to write
+ */
+void writeJsonString(std::ostream &out, const std::string &text);
+
+#endif // JSON_H
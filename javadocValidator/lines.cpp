@@ -0,0 +1,12 @@
+#include "lines.h"
+
+#include <algorithm>
+
+bool intersects(const LineRanges &ranges, unsigned first, unsigned last)
+{
+    //first range, which doesn't end before checked part
+    auto it = std::lower_bound(ranges.begin(), ranges.end(), first,
+                               [](const std::pair< unsigned, unsigned > &range,
+                                  unsigned line) { return range.second < line; });
+    return it != ranges.end() && it->first <= last;
+}
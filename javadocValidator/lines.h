@@ -0,0 +1,26 @@
+/**
+  * @author Team A
+  * @file lines.h
+  *
+  * @brief ranges of line numbers, e.g. changed lines of file
+  */
+#ifndef LINES_H
+#define LINES_H
+#include <utility>
+#include <vector>
+
+/**
+ * @brief LineRanges sorted and disjoint ranges of lines [first, last], numbered from 1
+ */
+typedef std::vector< std::pair< unsigned, unsigned > > LineRanges;
+
+/**
+ * @brief intersects checks, if some line of ranges is in [first, last]
+ * @param ranges changed lines
+ * @param first first line of checked part
+ * @param last last line of checked part
+ * @return true if checked part contains changed line
+ */
+bool intersects(const LineRanges &ranges, unsigned first, unsigned last);
+
+#endif // LINES_H
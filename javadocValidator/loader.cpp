@@ -0,0 +1,437 @@
+#include "loader.h"
+#include "trace.h"
+#include "perf.h"
+
+#include <algorithm>
+#include <climits>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+const unsigned FileLoader::queueDepth;
+const std::size_t FileLoader::streamBlock;
+
+FileLoader::FileLoader(const std::vector< std::string > &paths)
+    : paths(paths), nextPath(0), useRing(false), ringFd(-1),
+      sqRing(MAP_FAILED), sqRingSize(0), cqRing(MAP_FAILED), cqRingSize(0),
+      sqes(nullptr), sqesSize(0), sqLocalTail(0), sqSubmitted(0),
+      inFlight(0), readerDone(false), stopping(false)
+{
+    useRing = setupRing();
+
+    if (useRing)
+        fillRing();
+    else
+        reader = std::thread(&FileLoader::readAll, this);
+}
+
+FileLoader::~FileLoader()
+{
+    if (reader.joinable()) {
+        {
+            std::lock_guard< std::mutex > lock(mutex);
+            stopping = true;
+        }
+        readyChanged.notify_all();
+        reader.join();
+    }
+
+    //kernel may still write to buffers of pending reads
+    while (inFlight > 0 && enterRing(1))
+        reapRing();
+    for (auto &slot : slots)
+        if (slot.state != SlotState::free && slot.fd >= 0)
+            close(slot.fd);
+
+    if (sqes != nullptr)
+        munmap(sqes, sqesSize);
+    if (cqRing != MAP_FAILED && cqRing != sqRing)
+        munmap(cqRing, cqRingSize);
+    if (sqRing != MAP_FAILED)
+        munmap(sqRing, sqRingSize);
+    if (ringFd >= 0)
+        close(ringFd);
+}
+
+bool FileLoader::next(File &file)
+{
+    if (useRing) {
+        while (ready.empty() && inFlight > 0) {
+            if (!enterRing(1)) {
+                abandonRing();
+                break;
+            }
+            reapRing();
+        }
+    }
+    if (useRing) {
+        if (ready.empty())
+            return false;
+
+        file = std::move(ready.front());
+        ready.pop_front();
+        //keep kernel busy while the file is validated
+        fillRing();
+        return true;
+    }
+
+    std::unique_lock< std::mutex > lock(mutex);
+    readyChanged.wait(lock, [this] { return !ready.empty() || readerDone; });
+    if (ready.empty())
+        return false;
+
+    file = std::move(ready.front());
+    ready.pop_front();
+    readyChanged.notify_all();
+    return true;
+}
+
+void FileLoader::release(File &file)
+{
+    std::lock_guard< std::mutex > lock(mutex);
+    file.content.clear();
+    pool.push_back(std::move(file.content));
+}
+
+std::string FileLoader::takeBuffer()
+{
+    std::lock_guard< std::mutex > lock(mutex);
+    if (pool.empty())
+        return std::string();
+
+    std::string buffer(std::move(pool.back()));
+    pool.pop_back();
+    return buffer;
+}
+
+bool FileLoader::setupRing()
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+
+    ringFd = syscall(__NR_io_uring_setup, queueDepth, &params);
+    if (ringFd < 0)
+        return false;
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED)
+        return false;
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        cqRing = sqRing;
+    else
+        cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+    if (cqRing == MAP_FAILED)
+        return false;
+
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqesPtr = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqesPtr == MAP_FAILED)
+        return false;
+    sqes = static_cast< io_uring_sqe * >(sqesPtr);
+
+    char *sq = static_cast< char * >(sqRing);
+    sqHead = reinterpret_cast< unsigned * >(sq + params.sq_off.head);
+    sqTail = reinterpret_cast< unsigned * >(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast< unsigned * >(sq + params.sq_off.ring_mask);
+    sqEntries = params.sq_entries;
+    sqArray = reinterpret_cast< unsigned * >(sq + params.sq_off.array);
+    sqLocalTail = sqSubmitted = *sqTail;
+
+    char *cq = static_cast< char * >(cqRing);
+    cqHead = reinterpret_cast< unsigned * >(cq + params.cq_off.head);
+    cqTail = reinterpret_cast< unsigned * >(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast< unsigned * >(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast< io_uring_cqe * >(cq + params.cq_off.cqes);
+
+    slots.resize(std::min(queueDepth, sqEntries));
+    for (auto &slot : slots)
+        slot.state = SlotState::free;
+
+    return true;
+}
+
+io_uring_sqe *FileLoader::getSqe()
+{
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    if (sqLocalTail - head >= sqEntries)
+        return nullptr;
+
+    unsigned index = sqLocalTail & sqMask;
+    io_uring_sqe *sqe = &sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqArray[index] = index;
+    ++sqLocalTail;
+    return sqe;
+}
+
+void FileLoader::fillRing()
+{
+    for (unsigned i = 0; i < slots.size() && nextPath < paths.size(); ++i) {
+        if (slots[i].state != SlotState::free)
+            continue;
+
+        io_uring_sqe *sqe = getSqe();
+        if (sqe == nullptr)
+            break;
+
+        Slot &slot = slots[i];
+        slot.state = SlotState::opening;
+        slot.file = nextPath++;
+        slot.fd = -1;
+        slot.done = 0;
+        slot.begin = Trace::isEnabled() ? Trace::now() : 0;
+        slot.stream = false;
+
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast< std::uint64_t >(paths[slot.file].c_str());
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        sqe->user_data = i;
+        ++inFlight;
+    }
+    enterRing(0);
+}
+
+bool FileLoader::enterRing(unsigned wait)
+{
+    __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+    unsigned toSubmit = sqLocalTail - sqSubmitted;
+    if (toSubmit == 0 && wait == 0)
+        return true;
+
+    int submitted;
+    do {
+        submitted = syscall(__NR_io_uring_enter, ringFd, toSubmit, wait,
+                            wait > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+    } while (submitted < 0 && errno == EINTR);
+
+    if (submitted < 0)
+        return false;
+    sqSubmitted += submitted;
+    return true;
+}
+
+void FileLoader::abandonRing()
+{
+    useRing = false;
+    for (unsigned i = 0; i < slots.size(); ++i) {
+        Slot &slot = slots[i];
+        if (slot.state == SlotState::free)
+            continue;
+        if (slot.fd >= 0)
+            close(slot.fd);
+
+        File file;
+        file.path = paths[slot.file];
+        file.loaded = readFile(file.path, file.content);
+        ready.push_back(std::move(file));
+
+        //buffer stays in slot, pending read may still write to it
+        slot.state = SlotState::free;
+        slot.fd = -1;
+    }
+    inFlight = 0;
+    reader = std::thread(&FileLoader::readAll, this);
+}
+
+void FileLoader::reapRing()
+{
+    unsigned head = *cqHead;
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; ++head) {
+        io_uring_cqe *cqe = &cqes[head & cqMask];
+        auto slotIndex = static_cast< unsigned >(cqe->user_data);
+        int result = cqe->res;
+
+        //slot may submit next request, so completion is consumed first
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        handleCompletion(slotIndex, result);
+    }
+    enterRing(0);
+}
+
+void FileLoader::submitRead(unsigned slotIndex)
+{
+    Slot &slot = slots[slotIndex];
+    io_uring_sqe *sqe = getSqe();
+    if (sqe == nullptr) {
+        //every slot has at most one request, so this happens only on broken ring
+        finishSlot(slotIndex, false);
+        return;
+    }
+
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = slot.fd;
+    sqe->addr = reinterpret_cast< std::uint64_t >(&slot.buffer[slot.done]);
+    sqe->len = static_cast< unsigned >(std::min< std::size_t >
+                                       (slot.buffer.size() - slot.done, INT_MAX));
+    //offset -1 reads from current position, pipes can't seek
+    sqe->off = slot.stream ? static_cast< std::uint64_t >(-1) : slot.done;
+    sqe->user_data = slotIndex;
+    ++inFlight;
+}
+
+void FileLoader::handleCompletion(unsigned slotIndex, int result)
+{
+    Slot &slot = slots[slotIndex];
+    --inFlight;
+
+    switch (slot.state) {
+    case SlotState::opening: {
+        if (result == -EINVAL) //kernel without IORING_OP_OPENAT
+            result = open(paths[slot.file].c_str(), O_RDONLY | O_CLOEXEC);
+        if (result < 0) {
+            finishSlot(slotIndex, false);
+            return;
+        }
+
+        slot.fd = result;
+        struct stat info;
+        if (fstat(slot.fd, &info) < 0) {
+            finishSlot(slotIndex, false);
+            return;
+        }
+
+        //pipes and other files without size are read until end of file
+        slot.stream = !S_ISREG(info.st_mode);
+        slot.buffer = takeBuffer();
+        slot.buffer.resize(slot.stream ? streamBlock : info.st_size);
+        slot.state = SlotState::reading;
+        if (slot.buffer.empty())
+            finishSlot(slotIndex, true);
+        else
+            submitRead(slotIndex);
+        break;
+    }
+    case SlotState::reading: {
+        if (result == -EAGAIN || result == -EINTR) {
+            submitRead(slotIndex);
+            return;
+        }
+        if (result < 0) {
+            finishSlot(slotIndex, false);
+            return;
+        }
+        if (result == 0) { //end of stream, or file was truncated meanwhile
+            slot.buffer.resize(slot.done);
+            finishSlot(slotIndex, true);
+            return;
+        }
+
+        slot.done += result;
+        if (slot.stream && slot.done == slot.buffer.size())
+            slot.buffer.resize(slot.buffer.size() * 2);
+        if (slot.done == slot.buffer.size())
+            finishSlot(slotIndex, true);
+        else
+            submitRead(slotIndex);
+        break;
+    }
+    case SlotState::free:
+        break;
+    }
+}
+
+void FileLoader::finishSlot(unsigned slotIndex, bool loaded)
+{
+    Slot &slot = slots[slotIndex];
+    if (slot.fd >= 0)
+        close(slot.fd);
+
+    if (Trace::isEnabled())
+        Trace::recordAsync("load", paths[slot.file], slot.begin, Trace::now());
+
+    File file;
+    file.path = paths[slot.file];
+    file.content = std::move(slot.buffer);
+    file.loaded = loaded;
+    ready.push_back(std::move(file));
+
+    slot.state = SlotState::free;
+    slot.fd = -1;
+}
+
+void FileLoader::readAll()
+{
+    for (std::size_t i = nextPath; i < paths.size(); ++i) {
+        const std::string &path = paths[i];
+        File file;
+        file.path = path;
+        file.content = takeBuffer();
+
+        Trace::setFile(path);
+        file.loaded = readFile(path, file.content);
+
+        std::unique_lock< std::mutex > lock(mutex);
+        readyChanged.wait(lock, [this] { return ready.size() < queueDepth || stopping; });
+        if (stopping)
+            return;
+        ready.push_back(std::move(file));
+        readyChanged.notify_all();
+    }
+
+    std::lock_guard< std::mutex > lock(mutex);
+    readerDone = true;
+    readyChanged.notify_all();
+}
+
+bool FileLoader::readFile(const std::string &path, std::string &content)
+{
+    TraceSpan span("load");
+    PerfSpan counters("load");
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) < 0) {
+        close(fd);
+        return false;
+    }
+
+    std::size_t done = 0;
+    ssize_t length = 0;
+
+    if (!S_ISREG(info.st_mode)) {
+        //pipe has no size and can't seek, it is read until end
+        content.resize(streamBlock);
+        while ((length = read(fd, &content[done], content.size() - done)) > 0
+               || (length < 0 && errno == EINTR)) {
+            if (length > 0)
+                done += length;
+            if (done == content.size())
+                content.resize(content.size() * 2);
+        }
+        content.resize(done);
+        close(fd);
+        return length >= 0;
+    }
+
+    content.resize(info.st_size);
+    while (done < content.size()
+           && ((length = pread(fd, &content[done], content.size() - done, done)) > 0
+               || (length < 0 && errno == EINTR)))
+        if (length > 0)
+            done += length;
+
+    content.resize(done);
+    close(fd);
+    return length >= 0;
+}
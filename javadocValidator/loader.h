@@ -0,0 +1,188 @@
+/**
+  * @author Team A
+  * @file loader.h
+  *
+  * @brief class FileLoader reads many files at once, while they are validated
+  */
+#ifndef LOADER_H
+#define LOADER_H
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+class FileLoader
+{
+public:
+    struct File {
+        std::string path;
+        std::string content;
+        bool loaded;
+    };
+
+    /**
+     * @brief FileLoader ctor - starts loading of given files
+     *
+     * opens and reads are submitted in batches through io_uring,
+     * if io_uring is not available or fails, files are read by pread in
+     * a background thread, pipes and other files without size are read
+     * until end of file
+     *
+     * @param paths paths of files to load
+     */
+    FileLoader(const std::vector< std::string > &paths);
+    /**
+     * @brief ~FileLoader dtor - waits for pending reads and releases resources
+     */
+    ~FileLoader();
+
+    /**
+     * @brief next returns next loaded file, files are returned in order of completion
+     * @param file loaded file, loaded is false if file could not be read
+     * @return false if all files were already returned
+     */
+    bool next(File &file);
+    /**
+     * @brief release returns buffer of file to pool, so it is used for next file
+     * @param file file returned by next, which is no longer used
+     */
+    void release(File &file);
+
+private:
+    /**
+     * @brief queueDepth number of files, which are loaded at once
+     */
+    static const unsigned queueDepth = 32;
+    /**
+     * @brief streamBlock initial buffer for files without size
+     */
+    static const std::size_t streamBlock = 1 << 16;
+
+    enum class SlotState : std::uint8_t {
+        free,
+        opening,
+        reading
+    };
+
+    struct Slot {
+        SlotState state;
+        std::size_t file;
+        int fd;
+        std::string buffer;
+        std::size_t done;
+        std::int64_t begin;
+        /**
+         * @brief stream file without size (e.g. pipe), buffer grows until end of file
+         */
+        bool stream;
+    };
+
+    std::vector< std::string > paths;
+    std::size_t nextPath;
+    std::deque< File > ready;
+    std::vector< std::string > pool;
+
+    /* io_uring */
+    bool useRing;
+    int ringFd;
+    void *sqRing;
+    std::size_t sqRingSize;
+    void *cqRing;
+    std::size_t cqRingSize;
+    io_uring_sqe *sqes;
+    std::size_t sqesSize;
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned sqMask;
+    unsigned sqEntries;
+    unsigned *sqArray;
+    unsigned sqLocalTail;
+    unsigned sqSubmitted;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned cqMask;
+    io_uring_cqe *cqes;
+    std::vector< Slot > slots;
+    unsigned inFlight;
+
+    /* pread fallback */
+    std::thread reader;
+    std::mutex mutex;
+    std::condition_variable readyChanged;
+    bool readerDone;
+    bool stopping;
+
+    /**
+     * @brief setupRing creates io_uring and maps its queues
+     * @return false if io_uring is not available
+     */
+    bool setupRing();
+    /**
+     * @brief fillRing submits opens for free slots
+     */
+    void fillRing();
+    /**
+     * @brief enterRing submits prepared requests and waits for completions
+     * @param wait number of completions to wait for
+     * @return false if io_uring_enter failed
+     */
+    bool enterRing(unsigned wait);
+    /**
+     * @brief abandonRing switches to pread fallback after io_uring failure
+     *
+     * files of busy slots are read again by pread, slot buffers are not
+     * reused, kernel may still write to them
+     */
+    void abandonRing();
+    /**
+     * @brief reapRing handles all available completions
+     */
+    void reapRing();
+    /**
+     * @brief getSqe returns empty submission queue entry
+     * @return entry or nullptr if submission queue is full
+     */
+    io_uring_sqe *getSqe();
+    /**
+     * @brief submitRead submits read of remaining part of file in slot
+     * @param slotIndex index of slot
+     */
+    void submitRead(unsigned slotIndex);
+    /**
+     * @brief handleCompletion moves slot to its next state
+     * @param slotIndex index of slot
+     * @param result result of finished request
+     */
+    void handleCompletion(unsigned slotIndex, int result);
+    /**
+     * @brief finishSlot hands file of slot to ready files and frees slot
+     * @param slotIndex index of slot
+     * @param loaded true if whole file was read
+     */
+    void finishSlot(unsigned slotIndex, bool loaded);
+    /**
+     * @brief takeBuffer returns buffer from pool or new one
+     * @return empty buffer
+     */
+    std::string takeBuffer();
+
+    /**
+     * @brief readAll reads files from nextPath by pread, runs in reader thread
+     */
+    void readAll();
+    /**
+     * @brief readFile reads whole file by pread, or by read until end for pipes
+     * @param path path of the file
+     * @param content buffer, where the file is read
+     * @return false if file could not be read
+     */
+    static bool readFile(const std::string &path, std::string &content);
+};
+
+#endif // LOADER_H
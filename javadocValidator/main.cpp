@@ -10,49 +10,367 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <algorithm>
+#include <vector>
 
-#include "tokenizer.h"
-#include "parser.h"
+#include "validator.h"
+#include "watcher.h"
+#include "loader.h"
+#include "trace.h"
+#include "shard.h"
+#include "perf.h"
+#include "number.h"
 
 using namespace std;
 
-int main(int argc, char** argv)
+void printUsage(const char *program)
 {
-    if (argc < 2) {
-        std::cout << "Usage: " << argv[0]
-                  << " fileToCheck" << std::endl
-                  << "fileToCheck should be in specified without path, "
-                  << "just name of file, so it correspondes with "
-                  << "@file in header of file"
-                  << std::endl;
-        return -1;
-    }
+    std::cout << "Usage: " << program
+              << " [options] fileToCheck..." << std::endl
+              << "       " << program
+              << " [options] --watch directory" << std::endl
+              << "       " << program
+              << " [options] --stream file|-" << std::endl
+              << "fileToCheck should be in specified without path, "
+              << "just name of file, so it correspondes with "
+              << "@file in header of file"
+              << std::endl
+              << "more files are loaded in parallel and reported in order of loading"
+              << std::endl
+              << "- reads single file from standard input"
+              << std::endl
+              << "--watch validates files in directory after each change"
+              << std::endl
+              << "Options:" << std::endl
+              << "  --lazy            skip function bodies and undocumented code"
+              << std::endl
+              << "  --prefilter       reject files without doxygen comment after one scan,"
+              << std::endl
+              << "                    warnings about their quotes are not reported"
+              << std::endl
+              << "  --all-errors      report all errors, resume at next comment after error"
+              << std::endl
+              << "  --max-errors N    stop after N errors with --all-errors, 0 for no limit"
+              << std::endl
+              << "                    (default 100)"
+              << std::endl
+              << "  --trace file      write spans of validation stages as Chrome trace JSON"
+              << std::endl
+              << "  --perf-counters   report hardware counters of validation stages"
+              << std::endl
+              << "  --extract file    write brief, params and return of functions as JSON Lines"
+              << std::endl
+              << "  --diff file|-     validate only documentation changed in unified diff"
+              << std::endl
+              << "  --as fileName     name expected in @file of single file, e.g. of -"
+              << std::endl
+              << "  --stream file|-   validate files of stream, each as line \"<length> <fileName>\""
+              << std::endl
+              << "                    followed by length bytes of the file"
+              << std::endl
+              << "  --rules list      comma separated checks: author, file-version,"
+              << std::endl
+              << "                    unique-brief, params, unknown-tags, all or none"
+              << std::endl
+              << "  --shard i/N       validate only i-th of N parts of files, balanced by size"
+              << std::endl
+              << "  --result file     write results for --merge to file"
+              << std::endl
+              << "  --merge           fileToCheck are result files of all shards, print one report"
+              << std::endl;
+}
 
-    ifstream input;
-    input.open(argv[1], ios_base::in);
-    if (!input.is_open()) {
+int validateFile(const string &path, const string &fileName,
+                 const ValidationOptions &options)
+{
+    string inputString;
+    if (!loadFile(path, inputString)) {
         std::cout << "Given file could not be open" << std::endl
-                  << argv[1]
+                  << path
                   << " should be valid path."
                   << std::endl;
         return -1;
     }
-    string inputString(static_cast< stringstream const& >
-                       (stringstream() << input.rdbuf()).str());
 
-
-    Tokenizer t;
-    auto tree = t.tokenize(inputString);
-    Parser p(inputString, argv[1]);
-    p.initList(tree);
-    if (p.parseFile()) {
+    if (validate(inputString, fileName, options)) {
         cout << "Input is valid" << endl << endl;
     }
     else {
         cout << "Input is invalid" << endl << endl;
     }
+    return 0;
+}
+
+int validateFiles(const vector< string > &fileNames, const ValidationOptions &options,
+                  vector< FileResult > *results = nullptr)
+{
+    //files are validated while others are still being read
+    int result = 0;
+    FileLoader loader(fileNames);
+    FileLoader::File file;
+    while (loader.next(file)) {
+        FileResult fileResult = { file.path, file.loaded, false, string() };
+        cout << file.path << ":" << endl;
+        if (!file.loaded) {
+            std::cout << "Given file could not be open" << std::endl
+                      << file.path
+                      << " should be valid path."
+                      << std::endl << std::endl;
+            result = -1;
+        }
+        else if (results != nullptr) {
+            //diagnostics are kept for result file
+            ostringstream diagnostics;
+            fileResult.valid = validate(file.content, file.path, options, diagnostics);
+            fileResult.diagnostics = diagnostics.str();
+            cout << fileResult.diagnostics
+                 << (fileResult.valid ? "Input is valid" : "Input is invalid")
+                 << endl << endl;
+        }
+        else if (validate(file.content, file.path, options)) {
+            cout << "Input is valid" << endl << endl;
+        }
+        else {
+            cout << "Input is invalid" << endl << endl;
+        }
+        if (results != nullptr)
+            results->push_back(std::move(fileResult));
+        loader.release(file);
+    }
+    return result;
+}
+
+int validateStream(const string &path, const ValidationOptions &options)
+{
+    std::ifstream file;
+    if (path != "-") {
+        file.open(path, std::ios_base::in | std::ios_base::binary);
+        if (!file.is_open()) {
+            std::cout << "Given stream could not be open" << std::endl
+                      << path << " should be valid path or -."
+                      << std::endl;
+            return -1;
+        }
+    }
+    std::istream &input = (path == "-") ? std::cin : file;
+
+    string fileName;
+    string content;
+    StreamStatus status;
+    while ((status = readStreamFile(input, fileName, content)) == StreamStatus::file) {
+        //files without change have nothing to report
+        if (options.diff != nullptr && options.diff->find(fileName) == nullptr)
+            continue;
+
+        cout << fileName << ":" << endl;
+        if (validate(content, fileName, options)) {
+            cout << "Input is valid" << endl << endl;
+        }
+        else {
+            cout << "Input is invalid" << endl << endl;
+        }
+    }
 
-    input.close();
+    if (status == StreamStatus::malformed) {
+        std::cout << "Error: malformed stream, expected line \"<length> <fileName>\""
+                  << " followed by length bytes" << std::endl;
+        return -1;
+    }
     return 0;
 }
 
+int main(int argc, char** argv)
+{
+    vector< string > fileNames;
+    string watchDirectory;
+    string traceFile;
+    string diffFile;
+    string streamFile;
+    string expectedName;
+    string resultFile;
+    unsigned shardIndex = 1;
+    unsigned shardCount = 1;
+    bool merge = false;
+    bool perfCounters = false;
+    string extractFile;
+    ValidationOptions options;
+    DiffIndex diff;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg(argv[i]);
+        if (arg == "--watch" && i + 1 < argc)
+            watchDirectory = argv[++i];
+        else if (arg == "--lazy")
+            options.lazy = true;
+        else if (arg == "--prefilter")
+            options.prefilter = true;
+        else if (arg == "--all-errors")
+            options.collectAll = true;
+        else if (arg == "--max-errors" && i + 1 < argc) {
+            if (!parseCount(argv[++i], options.maxErrors)) {
+                std::cout << "Invalid number of errors " << argv[i] << std::endl;
+                printUsage(argv[0]);
+                return -1;
+            }
+        }
+        else if (arg == "--trace" && i + 1 < argc)
+            traceFile = argv[++i];
+        else if (arg == "--diff" && i + 1 < argc)
+            diffFile = argv[++i];
+        else if (arg == "--as" && i + 1 < argc)
+            expectedName = argv[++i];
+        else if (arg == "--stream" && i + 1 < argc)
+            streamFile = argv[++i];
+        else if (arg == "--rules" && i + 1 < argc) {
+            if (!parseRules(argv[++i], options.rules)) {
+                std::cout << "Unknown rule in " << argv[i] << std::endl;
+                printUsage(argv[0]);
+                return -1;
+            }
+        }
+        else if (arg == "--shard" && i + 1 < argc) {
+            if (!parseShard(argv[++i], shardIndex, shardCount)) {
+                std::cout << "Invalid shard " << argv[i]
+                          << ", expected i/N with 1 <= i <= N" << std::endl;
+                printUsage(argv[0]);
+                return -1;
+            }
+        }
+        else if (arg == "--result" && i + 1 < argc)
+            resultFile = argv[++i];
+        else if (arg == "--merge")
+            merge = true;
+        else if (arg == "--perf-counters")
+            perfCounters = true;
+        else if (arg == "--extract" && i + 1 < argc)
+            extractFile = argv[++i];
+        else
+            fileNames.push_back(arg);
+    }
+
+    if (merge) {
+        if (fileNames.empty()) {
+            printUsage(argv[0]);
+            return -1;
+        }
+        return mergeResults(fileNames);
+    }
+    bool sharded = shardCount > 1 || !resultFile.empty();
+    if (sharded && (!streamFile.empty() || !watchDirectory.empty() || !expectedName.empty())) {
+        std::cout << "--shard and --result can be used only with files" << std::endl;
+        return -1;
+    }
+
+    //trace, counters and extract are written at exit, which --watch never reaches
+    if (!watchDirectory.empty() && (!traceFile.empty() || perfCounters || !extractFile.empty())) {
+        std::cout << "--watch can't be combined with --trace, --perf-counters or --extract"
+                  << std::endl;
+        return -1;
+    }
+
+    if (!streamFile.empty() && !fileNames.empty()) {
+        std::cout << "--stream can't be combined with files" << std::endl;
+        return -1;
+    }
+    bool readsStdin = streamFile == "-"
+            || std::find(fileNames.begin(), fileNames.end(), "-") != fileNames.end();
+    if (readsStdin && (diffFile == "-" || fileNames.size() > 1)) {
+        std::cout << "Standard input can be read only once, "
+                  << "use --stream for more files" << std::endl;
+        return -1;
+    }
+    if (!expectedName.empty() && (fileNames.size() != 1 || !streamFile.empty())) {
+        std::cout << "--as can be used only with single file" << std::endl;
+        return -1;
+    }
+    if (fileNames.size() == 1 && expectedName.empty())
+        expectedName = fileNames[0];
+
+    if (!diffFile.empty()) {
+        if (!diff.load(diffFile)) {
+            std::cout << "Given diff could not be open" << std::endl
+                      << diffFile << " should be valid path or -."
+                      << std::endl;
+            return -1;
+        }
+        options.diff = &diff;
+
+        //files without change have nothing to report
+        auto unchanged = [&diff, &expectedName](const string &fileName) {
+            return diff.find(fileName == "-" ? expectedName : fileName) == nullptr;
+        };
+        fileNames.erase(std::remove_if(fileNames.begin(), fileNames.end(), unchanged),
+                        fileNames.end());
+        if (fileNames.empty() && watchDirectory.empty() && streamFile.empty() && !sharded)
+            return 0;
+    }
+
+    if (!watchDirectory.empty()) {
+        Watcher w(watchDirectory, options);
+        return w.run();
+    }
+
+    if (sharded && (!fileNames.empty() || options.diff != nullptr)) {
+        //each shard computes the same split, so no file is left out
+        fileNames = selectShard(fileNames, shardIndex, shardCount);
+        if (fileNames.empty() && !resultFile.empty()
+            && !writeResults(resultFile, shardIndex, shardCount, vector< FileResult >())) {
+            std::cout << "Error: result could not be written to " << resultFile << std::endl;
+            return -1;
+        }
+        if (fileNames.empty())
+            return 0;
+    }
+
+    if (fileNames.empty() && streamFile.empty()) {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    ofstream extract;
+    if (!extractFile.empty()) {
+        extract.open(extractFile, std::ios_base::out | std::ios_base::binary);
+        if (!extract.is_open()) {
+            std::cout << "Given extract file could not be open" << std::endl
+                      << extractFile << " should be valid path."
+                      << std::endl;
+            return -1;
+        }
+        options.extract = &extract;
+    }
+
+    if (!traceFile.empty())
+        Trace::enable();
+    string perfError;
+    if (perfCounters && !PerfCounters::enable(perfError))
+        std::cout << "Warning: performance counters are not available ("
+                  << perfError << "), --perf-counters is ignored" << std::endl;
+
+    int result;
+    vector< FileResult > results;
+    if (!streamFile.empty())
+        result = validateStream(streamFile, options);
+    else if (sharded)
+        result = validateFiles(fileNames, options, &results);
+    else if (fileNames.size() == 1)
+        result = validateFile(fileNames[0], expectedName, options);
+    else
+        result = validateFiles(fileNames, options);
+
+    if (!resultFile.empty() && !writeResults(resultFile, shardIndex, shardCount, results)) {
+        std::cout << "Error: result could not be written to " << resultFile << std::endl;
+        result = -1;
+    }
+
+    if (extract.is_open() && !extract.flush()) {
+        std::cout << "Error: extract could not be written to " << extractFile << std::endl;
+        result = -1;
+    }
+    if (PerfCounters::isEnabled())
+        PerfCounters::report(std::cout);
+    if (!traceFile.empty() && !Trace::write(traceFile))
+        std::cout << "Warning: trace could not be written to "
+                  << traceFile << std::endl;
+
+    return result;
+}
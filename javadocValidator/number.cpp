@@ -0,0 +1,21 @@
+#include "number.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+
+bool parseCount(const char *text, unsigned &count)
+{
+    //strtoul accepts sign and leading whitespace, count is only digits
+    if (*text < '0' || *text > '9')
+        return false;
+
+    char *end;
+    errno = 0;
+    unsigned long value = std::strtoul(text, &end, 10);
+    if (*end != '\0' || errno == ERANGE || value > UINT_MAX)
+        return false;
+
+    count = static_cast< unsigned >(value);
+    return true;
+}
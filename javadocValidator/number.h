@@ -0,0 +1,18 @@
+/**
+  * @author Team A
+  * @file number.h
+  *
+  * @brief numbers given on command line
+  */
+#ifndef NUMBER_H
+#define NUMBER_H
+
+/**
+ * @brief parseCount reads nonnegative decimal number
+ * @param text argument from command line
+ * @param count read number
+ * @return false if text is not only digits or number doesn't fit unsigned
+ */
+bool parseCount(const char *text, unsigned &count);
+
+#endif // NUMBER_H
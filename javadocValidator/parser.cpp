@@ -1,22 +1,51 @@
 #include "parser.h"
+#include "trace.h"
+#include "perf.h"
 
-Parser::Parser(std::string &code, std::string fileName)
-    : code(code), fileName(fileName)
+#include <iterator>
+
+template< class Policy >
+Parser< Policy >::Parser(std::string &code, std::string fileName, std::ostream &out)
+    : code(code), fileName(fileName), out(out),
+      collectAll(false), maxErrors(0), errorCount(0), checkHeader(true),
+      extracted(nullptr)
 {
 }
 
-Parser::~Parser()
+template< class Policy >
+Parser< Policy >::~Parser()
 {
     nonterminalsList.clear();
 }
 
-void Parser::initList(std::set<Tokenized, TokenizedComparator> inputSet)
+template< class Policy >
+void Parser< Policy >::setCollectAll(bool collectAll, unsigned maxErrors)
+{
+    this->collectAll = collectAll;
+    this->maxErrors = maxErrors;
+}
+
+template< class Policy >
+void Parser< Policy >::setCheckHeader(bool checkHeader)
+{
+    this->checkHeader = checkHeader;
+}
+
+template< class Policy >
+void Parser< Policy >::setExtract(std::vector< DocFunction > *functions)
+{
+    extracted = functions;
+}
+
+template< class Policy >
+void Parser< Policy >::initList(std::set<Tokenized, TokenizedComparator> inputSet)
 {
     std::list< Tokenized > tmpList(inputSet.begin(), inputSet.end());
     nonterminalsList = tmpList;
 }
 
-bool Parser::parseFile()
+template< class Policy >
+bool Parser< Policy >::parseFile()
 {
     filterRepeatingWhitespace();
 
@@ -27,32 +56,53 @@ bool Parser::parseFile()
     if (!iterateTroughtDocumentedFunctions())
         return false;
 
+    return errorCount == 0;
+}
+
+template< class Policy >
+bool Parser< Policy >::recoverFromError()
+{
+    ++errorCount;
+    if (!collectAll)
+        return false;
+
+    //further errors are unknown, so the limit is reported, not their count
+    if (maxErrors > 0 && errorCount >= maxErrors) {
+        out << "Error: limit of " << maxErrors << " errors reached, validation stopped"
+            << std::endl;
+        return false;
+    }
     return true;
 }
 
-void Parser::checkForBadKeyword(std::list< Tokenized >::iterator it)
+template< class Policy >
+std::list< Tokenized >::iterator Parser< Policy >::checkForBadKeyword(std::list< Tokenized >::iterator it)
 {
-    auto tmpIt = it; //found double quote begin
+    //@ is always inside of doxygen comment, so there is token before it
+    auto previous = std::prev(it);
 
-    --tmpIt;
-    if (isKeyword(tmpIt) && tmpIt->second == it->second) {
+    if (isKeyword(previous) && previous->second == it->second) {
         nonterminalsList.erase(it);
-        return;
+        return previous;
     }
-    ++tmpIt;
-    ++tmpIt;
-    if (isKeyword(tmpIt) && tmpIt->second == it->second) {
+    auto next = std::next(it);
+    if (next != nonterminalsList.end()
+        && isKeyword(next) && next->second == it->second) {
         nonterminalsList.erase(it);
-        return;
+        return previous;
     }
 
-    std::cout << "Warning: unrecognized keyword: " << getNextWord(it)
-              << std::endl;
-    return;
+    if (Policy::unknownTags)
+        out << "Warning: unrecognized keyword: " << getNextWord(it)
+            << std::endl;
+    return it;
 }
 
-bool Parser::filterUnreachableNontokens()
+template< class Policy >
+bool Parser< Policy >::filterUnreachableNontokens()
 {
+    TraceSpan span("Parser::filterUnreachableNontokens");
+    PerfSpan counters("Parser::filterUnreachableNontokens");
     std::list< Tokenized >::iterator beginIt;
     for (auto it = nonterminalsList.begin(); it != nonterminalsList.end(); ++it)
         switch (it->first) {
@@ -62,22 +112,24 @@ bool Parser::filterUnreachableNontokens()
                 ++it;
 
                 if (it == nonterminalsList.end()) {
-                    std::cout << "Error: code has unfinished doxygen comment"
-                              << std::endl;
+                    out << "Error: code has unfinished doxygen comment"
+                        << std::endl;
                     return false;
                 }
                 if (it->first == Tokens::at)
-                    checkForBadKeyword(it);
+                    it = checkForBadKeyword(it);
             }
             break;
         }
         case Tokens::cppComment: {
             beginIt = it; //found cpp comment begin
 
-            while (it->first != Tokens::newLine && it != nonterminalsList.end())
+            while (it != nonterminalsList.end() && it->first != Tokens::newLine)
                 ++it;
             //it is now end of comment
             nonterminalsList.erase(beginIt, it); //delete comment
+            if (it == nonterminalsList.end())
+                return true;
             break;
         }
         case Tokens::cCommentBegin: {
@@ -89,8 +141,8 @@ bool Parser::filterUnreachableNontokens()
             else {
                 while (it->first != Tokens::cCommentEnd) {
                     if (it == nonterminalsList.end()) {
-                        std::cout << "Warning: code has unfinished c comment"
-                                  << std::endl;
+                        out << "Warning: code has unfinished c comment"
+                            << std::endl;
                     }
                     ++it;
                     break;
@@ -98,6 +150,8 @@ bool Parser::filterUnreachableNontokens()
 
                 //it is now end of comment
                 nonterminalsList.erase(beginIt, it);
+                if (it == nonterminalsList.end())
+                    return true;
             }
             break;
         }
@@ -106,8 +160,8 @@ bool Parser::filterUnreachableNontokens()
 
             while (it->first != Tokens::doubleQuotes) {
                 if (it == nonterminalsList.end()) {
-                    std::cout << "Warning: code has unfinished double quotes"
-                              << std::endl;
+                    out << "Warning: code has unfinished double quotes"
+                        << std::endl;
                     break;
                 }
                 ++it;
@@ -122,7 +176,7 @@ bool Parser::filterUnreachableNontokens()
             //escaped characters are deleted = 0 characters between ''
             ++it;
             if (it == nonterminalsList.end()) {
-                std::cout << "Error: unfinished single quotes" << std::endl;
+                out << "Error: unfinished single quotes" << std::endl;
                 return false;
             }
             if (it->first == Tokens::singleQuotes) {
@@ -132,7 +186,7 @@ bool Parser::filterUnreachableNontokens()
             //one character between ' '
             ++it;
             if (it == nonterminalsList.end()) {
-                std::cout << "Error: unfinished single quotes" << std::endl;
+                out << "Error: unfinished single quotes" << std::endl;
                 return false;
             }
             if (it->first == Tokens::singleQuotes){
@@ -140,8 +194,8 @@ bool Parser::filterUnreachableNontokens()
                 break;
             }
 
-            std::cout << "Warning: missing end of single quote"
-                      << std::endl;
+            out << "Warning: missing end of single quote"
+                << std::endl;
             break;
         }
         default:
@@ -150,7 +204,8 @@ bool Parser::filterUnreachableNontokens()
     return true;
 }
 
-bool Parser::filterRepeatingSpaceOrTabs(std::list< Tokenized >::iterator it,
+template< class Policy >
+bool Parser< Policy >::filterRepeatingSpaceOrTabs(std::list< Tokenized >::iterator it,
                                         std::list< Tokenized >::iterator tmpIt)
 {
     //have to delete next whitespace, to correctly hold information about ends of words
@@ -179,7 +234,8 @@ bool Parser::filterRepeatingSpaceOrTabs(std::list< Tokenized >::iterator it,
     return true;
 }
 
-bool Parser::filterRepeatingNewlines(std::list< Tokenized >::iterator tmpIt,
+template< class Policy >
+bool Parser< Policy >::filterRepeatingNewlines(std::list< Tokenized >::iterator tmpIt,
                                      std::list< Tokenized >::iterator it)
 {
     //have to delete next whitespace, to correctly hold information about ends of words
@@ -208,8 +264,11 @@ bool Parser::filterRepeatingNewlines(std::list< Tokenized >::iterator tmpIt,
     return true;
 }
 
-void Parser::filterRepeatingWhitespace()
+template< class Policy >
+void Parser< Policy >::filterRepeatingWhitespace()
 {
+    TraceSpan span("Parser::filterRepeatingWhitespace");
+    PerfSpan counters("Parser::filterRepeatingWhitespace");
     auto tmpIt = nonterminalsList.begin();
     for (auto it = nonterminalsList.begin(); it != nonterminalsList.end(); ++it) {
         if (isSpaceOrTab(it)) {
@@ -226,21 +285,42 @@ void Parser::filterRepeatingWhitespace()
 
 
 
-bool Parser::parseHeader(std::list< Tokenized >::iterator it)
+template< class Policy >
+bool Parser< Policy >::parseHeader(std::list< Tokenized >::iterator it)
 {
+    TraceSpan span("Parser::parseHeader");
+    PerfSpan counters("Parser::parseHeader");
+
     auto beginIt = it;
 
+    if (!checkHeader) {
+        //skip header without any check
+        while (it != nonterminalsList.end() && it->first != Tokens::commentBegin)
+            ++it;
+        while (it != nonterminalsList.end() && it->first != Tokens::commentEnd)
+            ++it;
+        if (it != nonterminalsList.end())
+            ++it;
+        nonterminalsList.erase(beginIt, it);
+        return true;
+    }
+
+    if (it == nonterminalsList.end()) {
+        out << "Error: file with no doxygen" << std::endl;
+        return false;
+    }
     if (it->first != Tokens::commentBegin) {
-        std::cout << "Warning: Expected token commentBegin, got: "
-                  << code.substr(0, getEnd(it))
-                  << std::endl
-                  << "File should start with comment with @author value"
-                  << std::endl;
+        out << "Warning: Expected token commentBegin, got: "
+            << code.substr(byteOrderMarkLength(code),
+                           getEnd(it) - byteOrderMarkLength(code))
+            << std::endl
+            << "File should start with comment with @author value"
+            << std::endl;
         //move to first comment
         while (it->first != Tokens::commentBegin) {
             ++it;
             if (it == nonterminalsList.end()) {
-                std::cout << "Error: file with no doxygen" << std::endl;
+                out << "Error: file with no doxygen" << std::endl;
                 return false;
             }
         }
@@ -249,31 +329,49 @@ bool Parser::parseHeader(std::list< Tokenized >::iterator it)
     bool hasVersion = false;
     bool hasAuthor = false;
     bool hasBrief = false;
+    auto errorsBefore = errorCount;
+
+    //after recoverable error the rest of header is skipped
+    for(++it; it != nonterminalsList.end() && it->first != Tokens::commentEnd
+        && errorCount == errorsBefore; ++it) {
+        if (it->first == Tokens::commentBegin) {
+            out << "Error: new comment start inside of header comment"
+                << std::endl;
+            if (!recoverFromError())
+                return false;
+            break; //header ends here, new comment is handled as function doc
+        }
 
-    for(++it; it->first != Tokens::commentEnd; ++it) {
         switch (it->first) {
         case Tokens::atAuthor: {
+            if (!Policy::author)
+                break;
+
             if (hasAuthor) {
-                std::cout << "Warning: author command repeated" << std::endl;
+                out << "Warning: author command repeated" << std::endl;
             }
 
             if (getTextLine(it).empty()) {
-                std::cout << "Error: author position is empty" << std::endl;
-                return false;
+                out << "Error: author position is empty" << std::endl;
+                if (!recoverFromError())
+                    return false;
             }
 
             hasAuthor = true;
             break;
         }
         case Tokens::atBrief: {
-            if (hasBrief) {
-                std::cout << "Error: brief command repeated" << std::endl;
-                return false;
+            if (Policy::uniqueBrief && hasBrief) {
+                out << "Error: brief command repeated" << std::endl;
+                if (!recoverFromError())
+                    return false;
+                break;
             }
 
             if (getTextLine(it).empty()) {
-                std::cout << "Error: brief position is empty" << std::endl;
-                return false;
+                out << "Error: brief position is empty" << std::endl;
+                if (!recoverFromError())
+                    return false;
             }
 
             hasBrief = true;
@@ -281,24 +379,27 @@ bool Parser::parseHeader(std::list< Tokenized >::iterator it)
         }
         case Tokens::atFile: {
             if (hasFile) {
-                std::cout << "Error: file command repeated" << std::endl;
-                return false;
+                out << "Error: file command repeated" << std::endl;
+                if (!recoverFromError())
+                    return false;
+                break;
             }
 
             ++it; //step on next token (from @file)
             auto file = getNextWord(it);
             if (file.empty()) {
-                std::cout << "Error: file position is empty" << std::endl;
-                return false;
+                out << "Error: file position is empty" << std::endl;
+                if (!recoverFromError())
+                    return false;
             }
-
-            if (file != fileName) {
-                std::cout << "Error: file name doesnt match, expcted: "
-                          << fileName
-                          << ", got: "
-                          << file
-                          << std::endl;
-                return false;
+            else if (file != fileName) {
+                out << "Error: file name doesnt match, expcted: "
+                    << fileName
+                    << ", got: "
+                    << file
+                    << std::endl;
+                if (!recoverFromError())
+                    return false;
             }
 
             hasFile = true;
@@ -306,44 +407,53 @@ bool Parser::parseHeader(std::list< Tokenized >::iterator it)
         }
         case Tokens::atVersion: {
             if (hasVersion) {
-                std::cout << "Error: version command repeated" << std::endl;
-                return false;
+                out << "Error: version command repeated" << std::endl;
+                if (!recoverFromError())
+                    return false;
             }
 
             hasVersion = true;
             break;
         }
-        case Tokens::commentBegin: {
-                std::cout << "Error: new comment start inside of header comment"
-                          << std::endl;
-                return false;
-            }
         default:
             break;
         }
     }
 
-    ++it; //step on comment end
+    if (errorCount != errorsBefore) {
+        skipToNextComment(it);
+        nonterminalsList.erase(beginIt, it);
+        return true;
+    }
+
+    if (it != nonterminalsList.end() && it->first == Tokens::commentEnd)
+        ++it; //step on comment end
     nonterminalsList.erase(beginIt, it);
 
-    if (!hasAuthor) {
-        std::cout << "Error: missing @author command in header" << std::endl;
-        return false;
+    if (Policy::author && !hasAuthor) {
+        out << "Error: missing @author command in header" << std::endl;
+        if (!recoverFromError())
+            return false;
     }
-    if (!hasFile && !hasVersion) {
-        std::cout << "Error: missing both javadoc style @version and doxygen @file command in header"
-                  << std::endl;
-        return false;
+    if (Policy::fileVersion) {
+        if (!hasFile && !hasVersion) {
+            out << "Error: missing both javadoc style @version and doxygen @file command in header"
+                << std::endl;
+            if (!recoverFromError())
+                return false;
+        }
+        else if (!hasFile)
+            out << "Warning: missing @file command in header" << std::endl;
     }
-    if (!hasFile)
-        std::cout << "Warning: missing @file command in header" << std::endl;
 
     return true;
 }
 
-bool Parser::handleDoxygenComment(std::list< Tokenized >::iterator& it,
+template< class Policy >
+bool Parser< Policy >::handleDoxygenComment(std::list< Tokenized >::iterator& it,
                                   std::set< std::string > &params)
 {
+    TraceSpan span("Parser::handleDoxygenComment");
     bool hasBrief = false;
     bool hasReturn = false;
 
@@ -351,20 +461,22 @@ bool Parser::handleDoxygenComment(std::list< Tokenized >::iterator& it,
            && it->first != Tokens::commentEnd) {
         switch (it->first) {
         case Tokens::atBrief: {
-            if (hasBrief) {
-                std::cout << "Error: multiple @brief in comment" << std::endl;
-                return false;
+            if (Policy::uniqueBrief && hasBrief) {
+                out << "Error: multiple @brief in comment" << std::endl;
+                return recoverFromError();
             }
 
             ++it;
             if (it == nonterminalsList.end()) {
-                std::cout << "Error: unfinished doxygen" << std::endl;
-                return false;
+                out << "Error: unfinished doxygen" << std::endl;
+                return recoverFromError();
             }
 
             std::string brief = getNextWord(it);
             if (brief.empty())
-                std::cout << "Warning: @brief is empty" << std::endl;
+                out << "Warning: @brief is empty" << std::endl;
+            if (extracted != nullptr)
+                function.brief = getCommandText(it->second, it);
 
             hasBrief = true;
             break;
@@ -372,37 +484,47 @@ bool Parser::handleDoxygenComment(std::list< Tokenized >::iterator& it,
         case Tokens::atParam: {
             ++it;
             if (it == nonterminalsList.end()) {
-                std::cout << "Error: unfinished doxygen" << std::endl;
-                return false;
+                out << "Error: unfinished doxygen" << std::endl;
+                return recoverFromError();
             }
+            if (!Policy::params && extracted == nullptr)
+                break;
 
             std::string tmpParam = getNextWord(it);
+            if (extracted != nullptr) {
+                DocParam param = { tmpParam, getCommandText(getEnd(it), std::next(it)) };
+                function.params.push_back(param);
+            }
+            if (!Policy::params)
+                break;
             if (tmpParam.empty())
-                std::cout << "Warning: @param is empty" << std::endl;
+                out << "Warning: @param is empty" << std::endl;
 
             auto ret = params.insert(tmpParam);
             if (!ret.second) {
-                std::cout << "Warning: multiple declaration of @param: "
-                          << (*ret.first) << std::endl;
+                out << "Warning: multiple declaration of @param: "
+                    << (*ret.first) << std::endl;
             }
 
             break;
         }
         case Tokens::atReturn: {
             if (hasReturn) {
-                std::cout << "Error: multiple @return in comment" << std::endl;
-                return false;
+                out << "Error: multiple @return in comment" << std::endl;
+                return recoverFromError();
             }
 
             ++it;
             if (it == nonterminalsList.end()) {
-                std::cout << "Error: unfinished doxygen" << std::endl;
-                return false;
+                out << "Error: unfinished doxygen" << std::endl;
+                return recoverFromError();
             }
 
             std::string returnVal = getNextWord(it);
             if (returnVal.empty())
-                std::cout << "Warning: @return is empty" << std::endl;
+                out << "Warning: @return is empty" << std::endl;
+            if (extracted != nullptr)
+                function.returnText = getCommandText(it->second, it);
 
             hasReturn = true;
             break;
@@ -414,147 +536,259 @@ bool Parser::handleDoxygenComment(std::list< Tokenized >::iterator& it,
         ++it;
     }
 
-    ++it; //step over comment end
+    if (it != nonterminalsList.end()) {
+        function.comment.second = it->second + 2;
+        ++it; //step over comment end
+    }
 
     if (!hasBrief) {
-        std::cout << "Error: no @brief in comment" << std::endl;
-        return false;
+        out << "Error: no @brief in comment" << std::endl;
+        return recoverFromError();
     }
     return true;
 }
 
-bool Parser::handleFunction(std::list< Tokenized >::iterator& it,
+template< class Policy >
+bool Parser< Policy >::handleFunction(std::list< Tokenized >::iterator& it,
                             std::set< std::string > &params)
 {
-    //find opening left parenthesis
-    while (it != nonterminalsList.end()
-           && it->first != Tokens::lPar) {
-        if (it->first == Tokens::commentBegin) {
-            std::cout << "Warning: doxygen comment is without function."
-                      << "This is possible for header comment only." << std::endl;
-            return true;
-        }
-        ++it;
+    TraceSpan span("Parser::handleFunction");
+    if (!scanSignature(it, signature)) {
+        out << "Warning: doxygen comment is without function."
+            << "This is possible for header comment only." << std::endl;
+        return true;
+    }
+
+    if (extracted != nullptr) {
+        function.name = code.substr(signature.name.first,
+                                    signature.name.second - signature.name.first);
+        function.signature = DocFunction::Offsets(signature.name.first, signature.end);
     }
 
-    //--it; returnType = getNextWord(it); // get return value
     /*this enables parsing, if return value is void (better said _Noreturn),
      * so @return doesnt have to be specified
      * it is not supported
      */
 
-    std::string name = getPreviousWord(it);
+    if (signature.name.first == signature.name.second) {
+        out << "Error: could not handle function name, maybe wrong placed parenthesis"
+            << std::endl;
+        return recoverFromError();
+    }
 
-    if (name.empty()) {
-        std::cout << "Error: could not handle function name, maybe wrong placed parenthesis"
-                  << std::endl;
-        return false;
+    for (auto &param : signature.params) {
+        if (param.first == param.second) {
+            out << "Warning: function arg name is empty" << std::endl;
+            continue;
+        }
+
+        auto ret = params.insert(code.substr(param.first, param.second - param.first));
+        if (!ret.second) {
+            out << "Error: multiple params with name: "
+                << (*ret.first) << std::endl;
+            return recoverFromError();
+        }
+    }
+
+    if (signature.minAngleDepth < 0)
+        out << "Warning: more > than < in function" << std::endl;
+
+    return true;
+}
+
+template< class Policy >
+bool Parser< Policy >::scanSignature(std::list< Tokenized >::iterator &it,
+                                     Signature &signature)
+{
+    signature.params.clear();
+    signature.minAngleDepth = 0;
+    signature.end = code.size();
+
+    auto position = [this](std::list< Tokenized >::iterator token) {
+        return token == nonterminalsList.end() ? std::string::npos : token->second;
+    };
+    auto isWhitespace = [](std::list< Tokenized >::iterator token) {
+        return token->first == Tokens::space
+                || token->first == Tokens::tab
+                || token->first == Tokens::newLine;
+    };
+
+    //word ends before the token following its first token
+    bool hasWord = false;
+    Span word;
+    auto closeToken = [&](std::list< Tokenized >::iterator token,
+                          std::string::size_type next) {
+        if (isWhitespace(token) && token->second + 1 == next)
+            return false;
+        word = Span(token->second, std::min(next, code.size()));
+        hasWord = true;
+        return true;
+    };
+
+    //word of the first '(' can start before it, e.g. at comment end
+    if (it != nonterminalsList.begin()) {
+        auto token = std::prev(it);
+        auto next = position(it);
+        while (!closeToken(token, next) && token != nonterminalsList.begin()) {
+            next = token->second;
+            --token;
+        }
     }
 
+    //find opening left parenthesis
     while (it != nonterminalsList.end()
-           && it->first != Tokens::lPar)
-        ++it;
+           && it->first != Tokens::lPar) {
+        if (it->first == Tokens::commentBegin)
+            return false;
+        auto token = it++;
+        closeToken(token, position(it));
+    }
+    signature.name = hasWord ? trimWord(word) : Span(0, 0);
 
-    int openParenthesisCounter = 0;
-    int angleBracketsCounter = 0;
+    int parenthesisDepth = 0;
+    int angleDepth = 0;
     bool parenthesisEnded = false;
 
     while (it != nonterminalsList.end()
            && !parenthesisEnded) {
         switch (it->first) {
         case Tokens::lPar: {
-            ++openParenthesisCounter;
+            ++parenthesisDepth;
             break;
         }
         case Tokens::rPar: {
-            --openParenthesisCounter;
-            if (openParenthesisCounter == 0)
+            --parenthesisDepth;
+            if (parenthesisDepth == 0) {
                 parenthesisEnded = true;
+                signature.end = it->second + 1;
+            }
 
-            //break; //WARNING: commented to behave as comma
+            //rPar ends last argument as comma does
         }
+        /* fallthrough */
         case Tokens::comma: {
-            if (angleBracketsCounter > 0)
+            if (!Policy::params || angleDepth > 0)
                 break;
-            std::string tmp = getAttribute(it);
-            if (tmp.empty()) {
-                std::cout << "Warning: function arg name is empty" << std::endl;
-                break;
-            }
 
-            auto ret = params.insert(tmp);
-
-            if (!ret.second) {
-                std::cout << "Error: multiple params with name: "
-                          << (*ret.first) << std::endl;
-                return false;
-            }
+            //argument name without leading pointer and trailing array decoration
+            Span param = hasWord ? trimWord(word) : Span(0, 0);
+            while (param.first < param.second
+                   && (code[param.first] == '*' || code[param.first] == '&'
+                       || code[param.first] == '('))
+                ++param.first;
+            auto bracket = std::find(code.begin() + param.first,
+                                     code.begin() + param.second, '[');
+            param.second = bracket - code.begin();
+            signature.params.push_back(param);
             break;
         }
         case Tokens::lAngleBracket: {
-            ++angleBracketsCounter;
+            ++angleDepth;
             break;
         }
         case Tokens::rAngleBracket: {
-            --angleBracketsCounter;
-            if (openParenthesisCounter < 0)
-                std::cout << "Warning: more > than < in function" << std::endl;
-
+            --angleDepth;
+            signature.minAngleDepth = std::min(signature.minAngleDepth, angleDepth);
             break;
         }
         default:
             break;
         }
 
-        ++it;
+        auto token = it++;
+        closeToken(token, position(it));
     }
 
     return true;
 }
 
-void Parser::printArguments(std::set< std::string > dox, std::set< std::string > fun)
+template< class Policy >
+typename Parser< Policy >::Span Parser< Policy >::trimWord(Span word)
+{
+    while (word.first < word.second
+           && (code[word.first] == ' ' || code[word.first] == '\t'
+               || code[word.first] == '\r' || code[word.first] == '\n'))
+        ++word.first;
+    return word;
+}
+
+template< class Policy >
+void Parser< Policy >::printArguments(std::set< std::string > dox, std::set< std::string > fun)
 {
     for (auto &s : dox) {
-        std::cout << "dox arg: " << s <<std::endl;
+        out << "dox arg: " << s <<std::endl;
     }
     for (auto &s : fun) {
-        std::cout << "fun arg: " << s <<std::endl;
+        out << "fun arg: " << s <<std::endl;
     }
 }
 
-bool Parser::iterateTroughtDocumentedFunctions()
+template< class Policy >
+bool Parser< Policy >::iterateTroughtDocumentedFunctions()
 {
-    for (auto it = nonterminalsList.begin(); it != nonterminalsList.end(); ++it) {
+    TraceSpan span("Parser::iterateTroughtDocumentedFunctions");
+    PerfSpan counters("Parser::iterateTroughtDocumentedFunctions");
+    auto it = nonterminalsList.begin();
+    while (it != nonterminalsList.end()) {
         if (it->first != Tokens::commentBegin) {
             //nonterminalsList.erase(it);
+            ++it;
         }
         else {
             std::set< std::string > doxygenParms;
             std::set< std::string > functionParams;
+            auto errorsBefore = errorCount;
+            if (extracted != nullptr) {
+                function = DocFunction();
+                function.comment = DocFunction::Offsets(it->second, code.size());
+            }
 
             if (!handleDoxygenComment(it, doxygenParms))
                 return false;
 
-            if (!handleFunction(it, functionParams))
+            if (errorCount == errorsBefore && !handleFunction(it, functionParams))
                 return false;
 
-            if (doxygenParms != functionParams) {
-                std::cout << "Arguments are different to @params"
-                          << std::endl;
+            if (errorCount == errorsBefore && Policy::params
+                && doxygenParms != functionParams) {
+                out << "Arguments are different to @params"
+                    << std::endl;
 
                 printArguments(doxygenParms, functionParams);
-                return false;
+                if (!recoverFromError())
+                    return false;
             }
+
+            //comment without function has empty signature
+            if (extracted != nullptr && function.signature.second > function.signature.first) {
+                function.valid = errorCount == errorsBefore;
+                extracted->push_back(std::move(function));
+            }
+
+            //after recoverable error validation resumes at next comment
+            if (errorCount != errorsBefore)
+                skipToNextComment(it);
+            else if (it != nonterminalsList.end())
+                ++it;
         }
     }
     return true;
 }
 
-bool Parser::isSpaceOrTab(std::list< Tokenized >::iterator it) {
+template< class Policy >
+void Parser< Policy >::skipToNextComment(std::list< Tokenized >::iterator &it)
+{
+    while (it != nonterminalsList.end() && it->first != Tokens::commentBegin)
+        ++it;
+}
+
+template< class Policy >
+bool Parser< Policy >::isSpaceOrTab(std::list< Tokenized >::iterator it) {
     return (it->first == Tokens::space || it->first == Tokens::tab);
 }
 
-std::string::size_type Parser::getEnd(std::list< Tokenized >::iterator it)
+template< class Policy >
+std::string::size_type Parser< Policy >::getEnd(std::list< Tokenized >::iterator it)
 {
     ++it;
     if (it == nonterminalsList.end())
@@ -563,54 +797,44 @@ std::string::size_type Parser::getEnd(std::list< Tokenized >::iterator it)
     return it->second;
 }
 
-std::string Parser::getTextLine(std::list< Tokenized >::iterator &it)
+template< class Policy >
+std::string Parser< Policy >::getCommandText(std::string::size_type begin,
+                                             std::list< Tokenized >::iterator it)
 {
-    auto begin = it;
-    while (it->first != Tokens::newLine && it != nonterminalsList.end())
+    //unknown @ is part of text, e.g. in e-mail
+    while (it != nonterminalsList.end() && it->first != Tokens::commentEnd
+           && it->first != Tokens::commentBegin && !isKeyword(it))
         ++it;
 
-    return code.substr(begin->second, it->second);
-}
-
-std::string Parser::getNextWord(std::list< Tokenized >::iterator &it)
-{
-    std::string output = code.substr(it->second, getEnd(it) - it->second);
-    auto pos = output.find_first_not_of(" \t\n");
-    if (pos == std::string::npos)
+    auto end = (it == nonterminalsList.end()) ? code.size() : it->second;
+    if (begin >= end)
         return "";
-    else
-        return output.substr(pos, output.size());
+    return cleanDocText(code, begin, end);
 }
 
-std::string Parser::getPreviousWord(std::list< Tokenized >::iterator it)
+template< class Policy >
+std::string Parser< Policy >::getTextLine(std::list< Tokenized >::iterator &it)
 {
-    --it; //get before comma or rPar
-
-    while ((it->first == Tokens::space
-           || it->first == Tokens::tab
-           || it->first == Tokens::newLine)
-           && (it->second == getEnd(it) - 1)) //skip whitespace between function name and lPar
-        --it; //get back before whitespace
+    auto begin = it;
+    while (it->first != Tokens::newLine && std::next(it) != nonterminalsList.end())
+        ++it;
 
-    return getNextWord(it);
+    return code.substr(begin->second, it->second);
 }
 
-std::string Parser::getAttribute(std::list< Tokenized >::iterator it)
+template< class Policy >
+std::string Parser< Policy >::getNextWord(std::list< Tokenized >::iterator &it)
 {
-    std::string att = getPreviousWord(it);
-
-    auto beg = att.find_first_not_of("*&(");
-    auto end = att.find_first_of("[");
-    if (beg == std::string::npos)
+    std::string output = code.substr(it->second, getEnd(it) - it->second);
+    auto pos = output.find_first_not_of(" \t\r\n");
+    if (pos == std::string::npos)
         return "";
-    if (end == std::string::npos)
-        return att.substr(beg, end);
     else
-        return att.substr(beg, end-1); //cut the [
+        return output.substr(pos, output.size());
 }
 
-
-bool Parser::isDoxygenComment(std::list< Tokenized >::iterator it)
+template< class Policy >
+bool Parser< Policy >::isDoxygenComment(std::list< Tokenized >::iterator it)
 {
     auto tmpIt = it;
     ++tmpIt;
@@ -630,7 +854,8 @@ bool Parser::isDoxygenComment(std::list< Tokenized >::iterator it)
     return false;
 }
 
-bool Parser::isKeyword(std::list< Tokenized >::iterator it) {
+template< class Policy >
+bool Parser< Policy >::isKeyword(std::list< Tokenized >::iterator it) {
     return (it->first == Tokens::atAuthor
             || it->first == Tokens::atBrief
             || it->first == Tokens::atFile
@@ -641,3 +866,66 @@ bool Parser::isKeyword(std::list< Tokenized >::iterator it) {
             || it->first == Tokens::atLink
             || it->first == Tokens::atSince);
 }
+
+namespace {
+
+/**
+ * @brief ParserFactory picks specialization for mask of rules, masks are tried from Rules down
+ */
+template< unsigned Rules >
+struct ParserFactory {
+    static ParserBase *create(unsigned rules, std::string &code,
+                              const std::string &fileName, std::ostream &out)
+    {
+        if (rules == Rules)
+            return new Parser< RuleSet< Rules > >(code, fileName, out);
+        return ParserFactory< Rules - 1 >::create(rules, code, fileName, out);
+    }
+};
+
+template<>
+struct ParserFactory< 0 > {
+    static ParserBase *create(unsigned, std::string &code,
+                              const std::string &fileName, std::ostream &out)
+    {
+        return new Parser< RuleSet< 0 > >(code, fileName, out);
+    }
+};
+
+} // namespace
+
+std::unique_ptr< ParserBase > createParser(unsigned rules, std::string &code,
+                                           std::string fileName, std::ostream &out)
+{
+    return std::unique_ptr< ParserBase >
+            (ParserFactory< allRules >::create(rules & allRules, code, fileName, out));
+}
+
+bool parseRules(const std::string &names, unsigned &rules)
+{
+    rules = 0;
+    std::string::size_type begin = 0;
+    while (begin <= names.size()) {
+        auto end = names.find(',', begin);
+        if (end == std::string::npos)
+            end = names.size();
+        std::string name = names.substr(begin, end - begin);
+        begin = end + 1;
+
+        if (name == "author")
+            rules |= ruleAuthor;
+        else if (name == "file-version")
+            rules |= ruleFileVersion;
+        else if (name == "unique-brief")
+            rules |= ruleUniqueBrief;
+        else if (name == "params")
+            rules |= ruleParams;
+        else if (name == "unknown-tags")
+            rules |= ruleUnknownTags;
+        else if (name == "all")
+            rules |= allRules;
+        else if (name != "none")
+            return false;
+    }
+    return true;
+}
@@ -12,18 +12,96 @@
 #include <iterator>
 #include <algorithm>
 #include <tuple>
+#include <memory>
+#include <vector>
 
 #include "tokenizer.h"
+#include "extract.h"
 
-class Parser
+/**
+ * @brief Rule checks of Parser, which can be turned off, used as bit mask
+ */
+enum Rule : unsigned {
+    ruleAuthor = 1 << 0,        //!< required @author in header
+    ruleFileVersion = 1 << 1,   //!< required @file or @version in header
+    ruleUniqueBrief = 1 << 2,   //!< at most one @brief in comment
+    ruleParams = 1 << 3,        //!< @param equal to arguments of function
+    ruleUnknownTags = 1 << 4,   //!< warning for unknown @ command
+    allRules = (1 << 5) - 1
+};
+
+/**
+ * @brief parseRules reads comma separated names of rules
+ *
+ * names are author, file-version, unique-brief, params, unknown-tags,
+ * all and none
+ *
+ * @param names comma separated names
+ * @param rules mask of named rules
+ * @return false if some name is unknown
+ */
+bool parseRules(const std::string &names, unsigned &rules);
+
+/**
+ * @brief RuleSet compile-time policy of Parser
+ *
+ * disabled rule is constant false, so its check is removed by compiler
+ */
+template< unsigned Rules >
+struct RuleSet {
+    static const bool author = (Rules & ruleAuthor) != 0;
+    static const bool fileVersion = (Rules & ruleFileVersion) != 0;
+    static const bool uniqueBrief = (Rules & ruleUniqueBrief) != 0;
+    static const bool params = (Rules & ruleParams) != 0;
+    static const bool unknownTags = (Rules & ruleUnknownTags) != 0;
+};
+
+/**
+ * @brief ParserBase interface of Parser, independent on its rules
+ */
+class ParserBase
+{
+public:
+    virtual ~ParserBase() {}
+    virtual void initList(std::set< Tokenized, TokenizedComparator > inputSet) = 0;
+    virtual void setCollectAll(bool collectAll, unsigned maxErrors) = 0;
+    virtual void setCheckHeader(bool checkHeader) = 0;
+    virtual void setExtract(std::vector< DocFunction > *functions) = 0;
+    virtual bool parseFile() = 0;
+};
+
+/**
+ * @brief createParser creates Parser specialized for given rules
+ *
+ * each mask of rules has prebuilt specialization, this picks it at runtime
+ *
+ * @param rules mask of Rule
+ * @param code string with code to be parsed
+ * @param fileName name of the file, which is parsed
+ * @param out stream, where warnings and errors are written
+ * @return new parser
+ */
+std::unique_ptr< ParserBase > createParser(unsigned rules, std::string &code,
+                                           std::string fileName,
+                                           std::ostream &out = std::cout);
+
+/**
+ * @brief Parser checks tokens of one file
+ *
+ * Policy is RuleSet with enabled checks
+ */
+template< class Policy >
+class Parser : public ParserBase
 {
 public:
     /**
      * @brief Parser ctor
      * @param code string with code to be parsed
      * @param fileName name of the file, which is parsed
+     * @param out stream, where warnings and errors are written
      */
-    Parser(std::string &code, std::string fileName);
+    Parser(std::string &code, std::string fileName,
+           std::ostream &out = std::cout);
     /**
      * @brief ~Parser dtor
      */
@@ -32,16 +110,78 @@ public:
      * @brief initList initialize Parser with input set
      * @param inputSet parsed tokens
      */
-    void initList(std::set< Tokenized, TokenizedComparator > inputSet);
+    void initList(std::set< Tokenized, TokenizedComparator > inputSet) override;
+    /**
+     * @brief setCollectAll enables reporting of all errors instead of the first one
+     *
+     * after an error, validation continues with the next command or comment,
+     * so all problems of header, @brief, @param and @return are reported
+     *
+     * @param collectAll true to continue after recoverable errors
+     * @param maxErrors validation stops after this number of errors, 0 = no limit
+     */
+    void setCollectAll(bool collectAll, unsigned maxErrors) override;
+    /**
+     * @brief setCheckHeader enables validation of header
+     *
+     * unchecked header is only removed, e.g. when it is not changed in diff
+     *
+     * @param checkHeader false to skip validation of header
+     */
+    void setCheckHeader(bool checkHeader) override;
+    /**
+     * @brief setExtract enables collecting of documentation model
+     *
+     * documented functions are appended during validation, until it stops,
+     * offsets are positions in code given to Parser
+     *
+     * @param functions where functions are appended, nullptr to disable
+     */
+    void setExtract(std::vector< DocFunction > *functions) override;
     /**
      * @brief parseFile runs the validation
      * @return true if file is valid, false otherwise
      */
-    bool parseFile();
+    bool parseFile() override;
 private:
+    /**
+     * @brief Span [begin, end) positions of word in code
+     */
+    typedef std::pair< std::string::size_type, std::string::size_type > Span;
+
+    /**
+     * @brief Signature compact record of function signature
+     */
+    struct Signature {
+        Span name;
+        /**
+         * @brief params names of arguments without pointer and array decoration
+         */
+        std::vector< Span > params;
+        /**
+         * @brief minAngleDepth lowest depth of <>, negative if there are more > than <
+         */
+        int minAngleDepth;
+        /**
+         * @brief end position after ')' closing arguments
+         */
+        std::string::size_type end;
+    };
+
     std::list< Tokenized > nonterminalsList;
+    Signature signature;
     std::string code;
     std::string fileName;
+    std::ostream &out;
+    bool collectAll;
+    unsigned maxErrors;
+    unsigned errorCount;
+    bool checkHeader;
+    std::vector< DocFunction > *extracted;
+    /**
+     * @brief function documentation of currently validated function
+     */
+    DocFunction function;
 
     /*        Filter and check            */
     /**
@@ -86,10 +226,24 @@ private:
      * @brief checkForBadKeyword checks, if is in document used @ with unknown keyword
      * @param it position where to check keyword
      *
-     * doesn't move the iterator
+     * @ of known keyword is erased from list
      * unknow keyword is treated as warning, not error
+     *
+     * @return it, or token before it, if it was erased
      */
-    void checkForBadKeyword(std::list< Tokenized >::iterator it);
+    std::list< Tokenized >::iterator checkForBadKeyword(std::list< Tokenized >::iterator it);
+
+    /**
+     * @brief recoverFromError counts error and decides, if validation continues
+     * @return true if validation should continue after the error
+     */
+    bool recoverFromError();
+    /**
+     * @brief skipToNextComment moves it to next commentBegin, where validation
+     * resumes after recoverable error
+     * @param it position of the error, moved to next comment or end of list
+     */
+    void skipToNextComment(std::list< Tokenized >::iterator &it);
 
     /*        Main parsing part            */
     /**
@@ -137,11 +291,13 @@ private:
      */
     std::string::size_type getEnd(std::list< Tokenized >::iterator it);
     /**
-     * @brief getPreviousWord
-     * @param it
-     * @return
+     * @brief getCommandText text of doxygen command up to next command or comment end
+     * @param begin first position of text
+     * @param it token at or after begin
+     * @return text without comment decoration
      */
-    std::string getPreviousWord(std::list< Tokenized >::iterator it);
+    std::string getCommandText(std::string::size_type begin,
+                               std::list< Tokenized >::iterator it);
     /**
      * @brief getTextLine
      * @param it
@@ -174,11 +330,22 @@ private:
      */
     bool isKeyword(std::list< Tokenized >::iterator it);
     /**
-     * @brief getAttribute
-     * @param it
-     * @return
+     * @brief scanSignature reads function signature in one forward pass
+     *
+     * word before '(', ',' or ')' is text from the last token, which is not
+     * whitespace directly followed by other token, to the token after it
+     *
+     * @param it position after doxygen comment, moved after signature
+     * @param signature record of the signature, its buffers are reused
+     * @return false if doxygen comment is found before '('
+     */
+    bool scanSignature(std::list< Tokenized >::iterator &it, Signature &signature);
+    /**
+     * @brief trimWord skips leading whitespace of word
+     * @param word [begin, end) in code
+     * @return trimmed word
      */
-    std::string getAttribute(std::list< Tokenized >::iterator it);
+    Span trimWord(Span word);
 };
 
 #endif // PARSER_H
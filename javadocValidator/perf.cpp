@@ -0,0 +1,252 @@
+#include "perf.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+const char *counterNames[PerfCounters::counterCount] = {
+    "cycles", "instructions", "L1d read misses", "LLC misses", "branch misses"
+};
+
+struct Stage {
+    const char *name;
+    std::uint64_t calls;
+    PerfCounters::Values values;
+};
+
+/**
+ * @brief ThreadCounters counter group of one thread and its stages
+ */
+struct ThreadCounters {
+    bool opened = false;
+    int leader = -1;
+    /**
+     * @brief order counters in order of group read, -1 for not opened ones
+     */
+    int order[PerfCounters::counterCount];
+    unsigned openedCount = 0;
+    /**
+     * @brief fds all opened counters, leader is the first one
+     */
+    std::vector< int > fds;
+    std::vector< Stage > stages;
+
+    ~ThreadCounters() {
+        for (int fd : fds)
+            close(fd);
+    }
+};
+
+//counters are owned here, so stages of finished threads are reported too
+std::mutex registryMutex;
+std::vector< std::unique_ptr< ThreadCounters > > threads;
+std::uint64_t inputBytes = 0;
+
+thread_local ThreadCounters *threadCounters = nullptr;
+
+int openCounter(std::uint32_t type, std::uint64_t config, int groupFd)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED
+            | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast< int >(syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+
+/**
+ * @brief openCounters opens group of counters for calling thread
+ * @param counters counters of the thread
+ * @return errno of the first counter, which could not be opened, 0 if some was opened
+ */
+int openCounters(ThreadCounters &counters)
+{
+    static const std::uint64_t l1Misses = PERF_COUNT_HW_CACHE_L1D
+            | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    const std::pair< std::uint32_t, std::uint64_t > events[PerfCounters::counterCount] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, l1Misses },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES }
+    };
+
+    //events missing on the CPU (e.g. in virtual machine) are only left out
+    int error = 0;
+    counters.opened = true;
+    for (int i = 0; i < PerfCounters::counterCount; ++i) {
+        counters.order[i] = -1;
+        int fd = openCounter(events[i].first, events[i].second, counters.leader);
+        if (fd < 0) {
+            if (error == 0)
+                error = errno;
+            continue;
+        }
+        if (counters.leader < 0)
+            counters.leader = fd;
+        counters.fds.push_back(fd);
+        counters.order[i] = static_cast< int >(counters.openedCount++);
+    }
+    return counters.leader < 0 ? error : 0;
+}
+
+ThreadCounters &getCounters()
+{
+    if (threadCounters == nullptr) {
+        std::lock_guard< std::mutex > lock(registryMutex);
+        threads.emplace_back(new ThreadCounters());
+        threadCounters = threads.back().get();
+    }
+    if (!threadCounters->opened)
+        openCounters(*threadCounters);
+    return *threadCounters;
+}
+
+std::string paranoidLevel()
+{
+    std::ifstream in("/proc/sys/kernel/perf_event_paranoid");
+    std::string level;
+    if (!std::getline(in, level))
+        return "unknown";
+    return level;
+}
+
+} // namespace
+
+bool PerfCounters::enabled = false;
+
+bool PerfCounters::enable(std::string &reason)
+{
+    {
+        std::lock_guard< std::mutex > lock(registryMutex);
+        threads.emplace_back(new ThreadCounters());
+        threadCounters = threads.back().get();
+    }
+
+    int error = openCounters(*threadCounters);
+    if (error != 0) {
+        reason = std::string(std::strerror(error))
+                + ", perf_event_paranoid is " + paranoidLevel();
+        return false;
+    }
+    enabled = true;
+    return true;
+}
+
+void PerfCounters::read(Values &values)
+{
+    for (auto &value : values.value)
+        value = -1;
+
+    ThreadCounters &counters = getCounters();
+    if (counters.leader < 0)
+        return;
+
+    //nr, time enabled, time running, values in order of opening
+    std::uint64_t data[3 + counterCount];
+    if (::read(counters.leader, data, sizeof(data)) < 0 || data[2] == 0)
+        return;
+
+    //counters are multiplexed, if there are not enough of them
+    double scale = static_cast< double >(data[1]) / data[2];
+    for (int i = 0; i < counterCount; ++i)
+        if (counters.order[i] >= 0)
+            values.value[i] = static_cast< std::int64_t >(data[3 + counters.order[i]] * scale);
+}
+
+void PerfCounters::record(const char *name, const Values &begin, const Values &end)
+{
+    ThreadCounters &counters = getCounters();
+    auto stage = counters.stages.begin();
+    while (stage != counters.stages.end() && std::strcmp(stage->name, name) != 0)
+        ++stage;
+    if (stage == counters.stages.end()) {
+        Stage added = { name, 0, Values() };
+        stage = counters.stages.insert(stage, added);
+    }
+
+    ++stage->calls;
+    for (int i = 0; i < counterCount; ++i) {
+        //counter not available in one of the reads is not available at all
+        if (begin.value[i] < 0 || end.value[i] < 0 || stage->values.value[i] < 0)
+            stage->values.value[i] = -1;
+        else
+            stage->values.value[i] += end.value[i] - begin.value[i];
+    }
+}
+
+void PerfCounters::addInput(std::uint64_t bytes)
+{
+    std::lock_guard< std::mutex > lock(registryMutex);
+    inputBytes += bytes;
+}
+
+void PerfCounters::report(std::ostream &out)
+{
+    std::lock_guard< std::mutex > lock(registryMutex);
+
+    //stages of all threads, in order of first use
+    std::vector< Stage > stages;
+    for (auto &thread : threads) {
+        for (auto &stage : thread->stages) {
+            auto total = stages.begin();
+            while (total != stages.end() && std::strcmp(total->name, stage.name) != 0)
+                ++total;
+            if (total == stages.end()) {
+                stages.push_back(stage);
+                continue;
+            }
+            total->calls += stage.calls;
+            for (int i = 0; i < counterCount; ++i)
+                total->values.value[i] = (total->values.value[i] < 0 || stage.values.value[i] < 0)
+                        ? -1 : total->values.value[i] + stage.values.value[i];
+        }
+    }
+
+    double megabytes = inputBytes / 1e6;
+    auto flags = out.flags();
+    auto precision = out.precision();
+    out.setf(std::ios_base::fixed);
+    out.precision(3);
+
+    out << "Performance counters (user space, " << megabytes << " MB of input):" << std::endl;
+    out.precision(1);
+    for (auto &stage : stages) {
+        out << stage.name << " (" << stage.calls << " calls)" << std::endl;
+        for (int i = 0; i < counterCount; ++i) {
+            out << "  " << counterNames[i] << ": ";
+            if (stage.values.value[i] < 0) {
+                out << "not available" << std::endl;
+                continue;
+            }
+            out << stage.values.value[i];
+            if (megabytes > 0)
+                out << ", " << stage.values.value[i] / megabytes << " per MB";
+            out << std::endl;
+        }
+        if (stage.values.value[cycles] > 0 && stage.values.value[instructions] >= 0) {
+            out.precision(2);
+            out << "  instructions per cycle: "
+                << static_cast< double >(stage.values.value[instructions])
+                   / stage.values.value[cycles] << std::endl;
+            out.precision(1);
+        }
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
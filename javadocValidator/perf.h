@@ -0,0 +1,118 @@
+/**
+  * @author Team A
+  * @file perf.h
+  *
+  * @brief hardware performance counters of validation stages
+  */
+#ifndef PERF_H
+#define PERF_H
+#include <iostream>
+#include <string>
+#include <cstdint>
+
+class PerfCounters
+{
+public:
+    /**
+     * @brief Counter measured hardware events, in order of Values
+     */
+    enum Counter {
+        cycles,
+        instructions,
+        l1Misses,
+        llcMisses,
+        branchMisses,
+        counterCount
+    };
+
+    /**
+     * @brief Values counts of events, -1 if event could not be counted
+     */
+    struct Values {
+        std::int64_t value[counterCount];
+    };
+
+    /**
+     * @brief enable opens counters for calling thread
+     *
+     * other threads open their counters with their first span, counters are
+     * user space only, so they work with perf_event_paranoid up to 2
+     *
+     * @param reason why counters are not available, if they are not
+     * @return false if no counter could be opened, counting stays disabled then
+     */
+    static bool enable(std::string &reason);
+    /**
+     * @brief isEnabled
+     * @return true if stages are counted
+     */
+    static bool isEnabled() {
+        return enabled;
+    }
+
+    /**
+     * @brief read current values of counters of calling thread
+     * @param values counts scaled by time, when counter was scheduled
+     */
+    static void read(Values &values);
+    /**
+     * @brief record adds counts of finished stage of calling thread
+     * @param name name of stage, has to be string literal
+     * @param begin values at start of stage
+     * @param end values at end of stage
+     */
+    static void record(const char *name, const Values &begin, const Values &end);
+    /**
+     * @brief addInput counts validated bytes, for values per MB
+     * @param bytes size of validated input
+     */
+    static void addInput(std::uint64_t bytes);
+
+    /**
+     * @brief report writes totals and values per MB of input of each stage
+     *
+     * all threads, which counted stages, have to be finished or idle
+     *
+     * @param out output stream
+     */
+    static void report(std::ostream &out);
+
+private:
+    static bool enabled;
+};
+
+/**
+ * @brief PerfSpan counts events of one stage
+ *
+ * used only for stages, which run once per file, reading of counters is
+ * a system call
+ */
+class PerfSpan
+{
+public:
+    /**
+     * @brief PerfSpan ctor - reads counters, if counting is enabled
+     * @param name name of stage, has to be string literal
+     */
+    explicit PerfSpan(const char *name)
+        : name(name) {
+        if (PerfCounters::isEnabled())
+            PerfCounters::read(begin);
+    }
+    /**
+     * @brief ~PerfSpan dtor - records the stage
+     */
+    ~PerfSpan() {
+        if (PerfCounters::isEnabled()) {
+            PerfCounters::Values end;
+            PerfCounters::read(end);
+            PerfCounters::record(name, begin, end);
+        }
+    }
+
+private:
+    const char *name;
+    PerfCounters::Values begin;
+};
+
+#endif // PERF_H
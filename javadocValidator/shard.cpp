@@ -0,0 +1,232 @@
+#include "shard.h"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <iostream>
+#include <queue>
+#include <sstream>
+#include <tuple>
+
+#include <sys/stat.h>
+
+namespace {
+
+const char *resultMagic = "javadocValidator-result";
+
+/**
+ * @brief perFileCost bytes added to size of each file for open and parse overhead
+ */
+const std::uint64_t perFileCost = 1024;
+/**
+ * @brief largeFile files of this size and bigger are assigned by size, not by hash
+ */
+const std::uint64_t largeFile = 256 * 1024;
+
+std::uint64_t hashPath(const std::string &path)
+{
+    //FNV-1a, std::hash differs between standard libraries
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : path) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::uint64_t fileSize(const std::string &path)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) < 0)
+        return 0;
+    return static_cast< std::uint64_t >(info.st_size);
+}
+
+} // namespace
+
+bool parseShard(const std::string &text, unsigned &index, unsigned &count)
+{
+    auto slash = text.find('/');
+    if (slash == 0 || slash == std::string::npos || slash + 1 == text.size()
+        || text.find_first_not_of("0123456789/") != std::string::npos
+        || text.find('/', slash + 1) != std::string::npos)
+        return false;
+
+    try {
+        index = std::stoul(text.substr(0, slash));
+        count = std::stoul(text.substr(slash + 1));
+    }
+    catch (const std::out_of_range &) {
+        return false;
+    }
+    return index >= 1 && index <= count;
+}
+
+std::vector< std::string > selectShard(const std::vector< std::string > &paths,
+                                       unsigned index, unsigned count)
+{
+    struct Item {
+        std::uint64_t size;
+        std::uint64_t hash;
+        std::size_t position;
+    };
+
+    //the shard with the least bytes and the lowest number gets next large file
+    typedef std::pair< std::uint64_t, unsigned > Load;
+    std::vector< Load > hashed(count);
+    for (unsigned shard = 1; shard <= count; ++shard)
+        hashed[shard - 1] = Load(0, shard);
+
+    std::vector< bool > selected(paths.size(), false);
+    std::vector< Item > items;
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        Item item = { fileSize(paths[i]) + perFileCost, hashPath(paths[i]), i };
+        if (item.size >= largeFile + perFileCost) {
+            items.push_back(item);
+            continue;
+        }
+        unsigned shard = item.hash % count;
+        selected[i] = shard + 1 == index;
+        hashed[shard].first += item.size;
+    }
+
+    //largest first, hash and path decide files of equal size
+    std::sort(items.begin(), items.end(), [&paths](const Item &a, const Item &b) {
+        return std::make_tuple(b.size, a.hash, std::cref(paths[a.position]))
+                < std::make_tuple(a.size, b.hash, std::cref(paths[b.position]));
+    });
+
+    std::priority_queue< Load, std::vector< Load >, std::greater< Load > >
+            loads(hashed.begin(), hashed.end());
+    for (auto &item : items) {
+        Load load = loads.top();
+        loads.pop();
+        if (load.second == index)
+            selected[item.position] = true;
+        load.first += item.size;
+        loads.push(load);
+    }
+
+    std::vector< std::string > shard;
+    for (std::size_t i = 0; i < paths.size(); ++i)
+        if (selected[i])
+            shard.push_back(paths[i]);
+    return shard;
+}
+
+bool writeResults(const std::string &path, unsigned index, unsigned count,
+                  const std::vector< FileResult > &results)
+{
+    std::ofstream out(path, std::ios_base::out | std::ios_base::binary);
+    if (!out.is_open())
+        return false;
+
+    //"<status> <length> <path>" followed by length bytes of diagnostics
+    out << resultMagic << " " << index << "/" << count << "\n";
+    for (auto &result : results) {
+        const char *status = !result.loaded ? "unreadable"
+                                            : (result.valid ? "valid" : "invalid");
+        out << status << " " << result.diagnostics.size() << " " << result.path << "\n"
+            << result.diagnostics;
+    }
+    return out.good();
+}
+
+namespace {
+
+bool readResults(const std::string &path, unsigned &index, unsigned &count,
+                 std::vector< FileResult > &results)
+{
+    std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+    if (!in.is_open())
+        return false;
+
+    std::string line;
+    if (!std::getline(in, line) || line.compare(0, std::string(resultMagic).size() + 1,
+                                                std::string(resultMagic) + " ") != 0
+        || !parseShard(line.substr(std::string(resultMagic).size() + 1), index, count))
+        return false;
+
+    while (std::getline(in, line)) {
+        std::istringstream header(line);
+        std::string status;
+        std::size_t length;
+        if (!(header >> status >> length) || header.get() != ' ')
+            return false;
+
+        if (status != "valid" && status != "invalid" && status != "unreadable")
+            return false;
+
+        FileResult result;
+        std::getline(header, result.path);
+        result.loaded = status != "unreadable";
+        result.valid = status == "valid";
+
+        result.diagnostics.resize(length);
+        if (length > 0 && !in.read(&result.diagnostics[0], length))
+            return false;
+        results.push_back(std::move(result));
+    }
+    return in.eof();
+}
+
+} // namespace
+
+int mergeResults(const std::vector< std::string > &paths)
+{
+    std::vector< FileResult > results;
+    std::vector< bool > shards;
+    unsigned expectedCount = 0;
+    int exitCode = 0;
+
+    for (auto &path : paths) {
+        unsigned index;
+        unsigned count;
+        std::vector< FileResult > shardResults;
+        if (!readResults(path, index, count, shardResults)) {
+            std::cout << "Error: result file " << path << " could not be read" << std::endl;
+            exitCode = -1;
+            continue;
+        }
+        if (expectedCount == 0) {
+            expectedCount = count;
+            shards.assign(count + 1, false);
+        }
+        if (count != expectedCount || shards[index]) {
+            std::cout << "Error: result file " << path << " is shard " << index << "/"
+                      << count << ", which doesn't fit other shards" << std::endl;
+            exitCode = -1;
+            continue;
+        }
+        shards[index] = true;
+        std::move(shardResults.begin(), shardResults.end(), std::back_inserter(results));
+    }
+
+    std::stable_sort(results.begin(), results.end(),
+                     [](const FileResult &a, const FileResult &b) { return a.path < b.path; });
+
+    for (auto &result : results) {
+        std::cout << result.path << ":" << std::endl;
+        if (!result.loaded) {
+            std::cout << "Given file could not be open" << std::endl
+                      << result.path
+                      << " should be valid path."
+                      << std::endl << std::endl;
+            exitCode = -1;
+            continue;
+        }
+
+        std::cout << result.diagnostics
+                  << (result.valid ? "Input is valid" : "Input is invalid")
+                  << std::endl << std::endl;
+    }
+
+    for (unsigned index = 1; index <= expectedCount; ++index)
+        if (!shards[index]) {
+            std::cout << "Error: missing result of shard " << index << "/"
+                      << expectedCount << std::endl;
+            exitCode = -1;
+        }
+    return exitCode;
+}
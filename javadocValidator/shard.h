@@ -0,0 +1,77 @@
+/**
+  * @author Team A
+  * @file shard.h
+  *
+  * @brief splitting of input files between machines and merging of their results
+  */
+#ifndef SHARD_H
+#define SHARD_H
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief FileResult result of one validated file, stored in result file of shard
+ */
+struct FileResult {
+    std::string path;
+    /**
+     * @brief loaded false if file could not be read
+     */
+    bool loaded;
+    bool valid;
+    /**
+     * @brief diagnostics warnings and errors written by validation
+     */
+    std::string diagnostics;
+};
+
+/**
+ * @brief parseShard reads shard in form i/N, 1 <= i <= N
+ * @param text shard given on command line
+ * @param index i
+ * @param count N
+ * @return false if text is not valid shard
+ */
+bool parseShard(const std::string &text, unsigned &index, unsigned &count);
+
+/**
+ * @brief selectShard picks files of one shard
+ *
+ * every shard computes the same assignment from paths and sizes of files,
+ * files smaller than 256 KiB go to shard given by hash of path, so they stay
+ * in their shard, when other files are added or removed, larger files are
+ * then assigned biggest first, each to the shard with the least bytes,
+ * the result doesn't depend on order of paths on command line
+ *
+ * @param paths all input files
+ * @param index shard, 1 <= index <= count
+ * @param count number of shards
+ * @return files of the shard, in the order of paths
+ */
+std::vector< std::string > selectShard(const std::vector< std::string > &paths,
+                                       unsigned index, unsigned count);
+
+/**
+ * @brief writeResults writes results of shard to file for later merge
+ * @param path path of result file
+ * @param index shard
+ * @param count number of shards
+ * @param results results of files of the shard
+ * @return false if file could not be written
+ */
+bool writeResults(const std::string &path, unsigned index, unsigned count,
+                  const std::vector< FileResult > &results);
+
+/**
+ * @brief mergeResults reads result files of all shards and prints one report
+ *
+ * files are reported in order of paths, exit code is the same as of one
+ * run over all files
+ *
+ * @param paths result files, one per shard
+ * @return 0, or -1 if some file or shard result is missing or unreadable
+ */
+int mergeResults(const std::vector< std::string > &paths);
+
+#endif // SHARD_H
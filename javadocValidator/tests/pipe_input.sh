@@ -0,0 +1,48 @@
+#!/bin/sh
+# checks, that pipes are read whole, as one file and as more files loaded together
+#   usage: pipe_input.sh [path to javadocValidator]
+VALIDATOR=$(cd "$(dirname "${1:-../javadocValidator}")" && pwd)/$(basename "${1:-../javadocValidator}")
+WORK=$(mktemp -d) || exit 1
+trap 'rm -rf "$WORK"' EXIT
+cd "$WORK" || exit 1
+failed=0
+
+# header and function after more than one read block, so pipe is read until its end
+source_of() {
+    printf '/**\n * @author Test\n * @file %s\n * @brief pipe input\n */\n' "$1"
+    head -c 200000 /dev/zero | tr '\0' '\n'
+    printf '/**\n * @brief sum\n * @param a first\n * @param b second\n * @return a + b\n */\n'
+    printf 'int sum(int a, int b)\n{\n    return a + b;\n}\n'
+}
+
+check() {
+    name=$1
+    shift
+    if "$VALIDATOR" "$@" > output 2>&1 && ! grep -q "Input is invalid\|could not be open" output \
+        && [ "$(grep -c "Input is valid" output)" -eq "$expected" ]; then
+        echo "ok: $name"
+    else
+        echo "FAILED: $name"
+        cat output
+        failed=1
+    fi
+    # writer of pipe, which was not read, would block forever
+    kill $(jobs -p) 2>/dev/null
+    wait
+}
+
+mkfifo one.c two.c
+source_of one.c > one.c &
+expected=1 check "single pipe" one.c
+
+source_of one.c > one.c &
+source_of two.c > two.c &
+expected=2 check "two pipes" one.c two.c
+
+source_of regular.c > regular.c
+source_of two.c > two.c &
+expected=2 check "pipe and regular file" regular.c two.c
+
+source_of stdin.c | { expected=1 check "standard input" --as stdin.c -; }
+
+exit $failed
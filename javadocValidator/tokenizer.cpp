@@ -1,4 +1,73 @@
 #include "tokenizer.h"
+#include "trace.h"
+#include "perf.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+std::string::size_type byteOrderMarkLength(const std::string &input)
+{
+    return (input.compare(0, 3, "\xEF\xBB\xBF") == 0) ? 3 : 0;
+}
+
+std::string::size_type findInvalidUtf8(const std::string &input)
+{
+    const unsigned char *data = reinterpret_cast< const unsigned char * >(input.data());
+    std::string::size_type size = input.size();
+    std::string::size_type pos = 0;
+
+    while (pos < size) {
+        //skip ASCII by words, memcpy is the aligned-safe load
+        while (pos + sizeof(std::uint64_t) <= size) {
+            std::uint64_t word;
+            std::memcpy(&word, data + pos, sizeof(word));
+            if ((word & 0x8080808080808080ULL) != 0)
+                break;
+            pos += sizeof(word);
+        }
+        if (pos >= size)
+            break;
+
+        unsigned char lead = data[pos];
+        if (lead < 0x80) {
+            ++pos;
+            continue;
+        }
+
+        //range of the second byte excludes overlong forms, surrogates and > U+10FFFF
+        std::string::size_type length;
+        unsigned char low = 0x80;
+        unsigned char high = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF)
+            length = 2;
+        else if (lead >= 0xE0 && lead <= 0xEF) {
+            length = 3;
+            if (lead == 0xE0)
+                low = 0xA0;
+            else if (lead == 0xED)
+                high = 0x9F;
+        }
+        else if (lead >= 0xF0 && lead <= 0xF4) {
+            length = 4;
+            if (lead == 0xF0)
+                low = 0x90;
+            else if (lead == 0xF4)
+                high = 0x8F;
+        }
+        else
+            return pos;
+
+        if (pos + 1 >= size || data[pos + 1] < low || data[pos + 1] > high)
+            return pos;
+        for (std::string::size_type i = 2; i < length; ++i)
+            if (pos + i >= size || (data[pos + i] & 0xC0) != 0x80)
+                return pos;
+        pos += length;
+    }
+    return std::string::npos;
+}
 
 Tokenizer::Tokenizer()
 {
@@ -21,6 +90,7 @@ Tokenizer::Tokenizer()
     tokenArray[ static_cast< std::size_t > (Tokens::comma) ] = ",";
     tokenArray[ static_cast< std::size_t > (Tokens::space) ] = " ";
     tokenArray[ static_cast< std::size_t > (Tokens::newLine) ] = "\n";
+    //"\r\n" is matched as newLine too, see matchToken
     tokenArray[ static_cast< std::size_t > (Tokens::tab) ] = "\t";
 
     tokenArray[ static_cast< std::size_t > (Tokens::at) ] = "@";
@@ -29,6 +99,21 @@ Tokenizer::Tokenizer()
     tokenArray[ static_cast< std::size_t > (Tokens::cppComment) ] = "//";
     tokenArray[ static_cast< std::size_t > (Tokens::singleQuotes) ] = "'";
     tokenArray[ static_cast< std::size_t > (Tokens::doubleQuotes) ] = "\"";
+
+    for (Tokens token = Tokens::all;
+        token < Tokens::NonterminalsCount;
+        token = (Tokens)(std::underlying_type<Tokens>::type(token) + 1)) {
+
+        std::string &tokenString = tokenArray[ static_cast< std::size_t > (token) ];
+        if (!tokenString.empty())
+            firstCharTokens[ static_cast< unsigned char > (tokenString[0]) ].push_back(token);
+    }
+
+    threads = std::max(1u, std::thread::hardware_concurrency());
+    lazy = false;
+    prefilter = false;
+    changedLines = nullptr;
+    headerChanged = true;
 }
 
 Tokenizer::~Tokenizer()
@@ -38,32 +123,352 @@ Tokenizer::~Tokenizer()
 
 std::set< Tokenized, TokenizedComparator > Tokenizer::tokenize(std::string &input)
 {
+    TraceSpan span("Tokenizer::tokenize");
+    PerfSpan counters("Tokenizer::tokenize");
+    bool undocumented = prefilter && !mayContainDoxygen(input);
     removeBackslashes(input);
+    headerChanged = true;
 
-    for (Tokens token = Tokens::all;
-        token < Tokens::NonterminalsCount;
-        token = (Tokens)(std::underlying_type<Tokens>::type(token) + 1)) {
+    if (undocumented) {
+        //whole input is header
+        if (changedLines != nullptr)
+            headerChanged = !changedLines->empty();
+
+        std::vector< Tokenized > tokens;
+        if (tokenizeLeading(input, tokens)) {
+            tokenTree.insert(tokens.begin(), tokens.end());
+            return tokenTree;
+        }
+    }
+
+    if (lazy || changedLines != nullptr) {
+        std::vector< Tokenized > tokens;
+        tokenizeLazy(input, tokens);
+        tokenTree.insert(tokens.begin(), tokens.end());
+        return tokenTree;
+    }
+
+    std::string::size_type chunks = std::min< std::string::size_type >
+            (threads, input.size() / minChunkSize);
+
+    if (chunks <= 1) {
+        std::vector< Tokenized > tokens;
+        tokenizeRange(input, byteOrderMarkLength(input), input.size(), tokens);
+        tokenTree.insert(tokens.begin(), tokens.end());
+        return tokenTree;
+    }
+
+    std::vector< std::vector< Tokenized > > chunkTokens(chunks);
+    std::vector< std::thread > workers;
+    std::string::size_type chunkSize = input.size() / chunks;
+
+    for (std::string::size_type i = 0; i < chunks; ++i) {
+        auto begin = (i == 0) ? byteOrderMarkLength(input) : i * chunkSize;
+        auto end = (i + 1 == chunks) ? input.size() : begin + chunkSize;
+        workers.emplace_back(&Tokenizer::tokenizeRange, this,
+                             std::cref(input), begin, end,
+                             std::ref(chunkTokens[i]));
+    }
+
+    //chunks are sorted and disjoint, so they are appended in order
+    for (std::string::size_type i = 0; i < chunks; ++i) {
+        workers[i].join();
+        for (auto &token : chunkTokens[i])
+            tokenTree.insert(tokenTree.end(), token);
+    }
+    return tokenTree;
+}
+
+void Tokenizer::setLazy(bool lazy)
+{
+    this->lazy = lazy;
+}
+
+void Tokenizer::setPrefilter(bool prefilter)
+{
+    this->prefilter = prefilter;
+}
+
+void Tokenizer::setChangedLines(const LineRanges *changedLines)
+{
+    this->changedLines = changedLines;
+}
+
+bool Tokenizer::isHeaderChanged() const
+{
+    return headerChanged;
+}
+
+std::string::size_type Tokenizer::originalOffset(std::string::size_type pos) const
+{
+    auto after = std::upper_bound(removedBytes.begin(), removedBytes.end(),
+                                  std::make_pair(pos, std::string::npos));
+    if (after == removedBytes.begin())
+        return pos;
+    return pos + std::prev(after)->second;
+}
+
+bool Tokenizer::mayContainDoxygen(const std::string &input) const
+{
+    const char *data = input.data();
+    const char *slash = data;
+    const char *end = data + input.size();
+
+    //memchr is vectorized, so only slashes are checked one by one
+    while ((slash = static_cast< const char * >
+            (std::memchr(slash, '/', end - slash))) != nullptr) {
+        std::string::size_type pos = slash - data + 1;
+        int asterisks = 0;
+
+        //backslashes are not removed yet, skip them as removeBackslashes would
+        while (pos < input.size() && asterisks < 2) {
+            if (input[pos] == '\\')
+                pos += (input.compare(pos + 1, 2, "\r\n") == 0) ? 3 : 2;
+            else if (input[pos] == '*') {
+                ++asterisks;
+                ++pos;
+            }
+            else
+                break;
+        }
+        if (asterisks == 2)
+            return true;
+        ++slash;
+    }
+    return false;
+}
+
+bool Tokenizer::tokenizeLeading(const std::string &input,
+                                std::vector< Tokenized > &output) const
+{
+    auto isSpaceOrTab = [](Tokens t) { return t == Tokens::space || t == Tokens::tab; };
+
+    Tokens token;
+    Tokens previous = Tokens::NonterminalsCount;
+    std::string::size_type previousPos = 0;
+    bool inCppComment = false;
+
+    for (std::string::size_type pos = byteOrderMarkLength(input);
+         pos < input.size() && output.size() < 2; ++pos) {
+        if (!matchToken(input, pos, token))
+            continue;
+
+        //parser merges runs of spaces and tabs and runs of newlines
+        bool merged = (pos == previousPos + 1)
+                && ((isSpaceOrTab(previous) && isSpaceOrTab(token))
+                    || (previous == Tokens::newLine && token == Tokens::newLine));
+        previous = token;
+        previousPos = pos;
+        if (merged)
+            continue;
+
+        //then it erases C++ comments up to newline and begins of C comments
+        if (inCppComment && token != Tokens::newLine)
+            continue;
+        inCppComment = false;
 
-        std::string tokenString = tokenArray[ static_cast< std::size_t > (token) ];
-        if (tokenString.empty())
+        if (token == Tokens::cppComment) {
+            inCppComment = true;
             continue;
+        }
+        if (token == Tokens::cCommentBegin)
+            continue;
+        //quotes are filtered depending on following tokens, full tree is needed
+        if (token == Tokens::doubleQuotes || token == Tokens::singleQuotes)
+            return false;
+
+        output.push_back(std::make_pair(token, pos));
+    }
+    return !inCppComment;
+}
 
-        std::string::size_type pos = 0;
+void Tokenizer::tokenizeRange(const std::string &input,
+                              std::string::size_type begin,
+                              std::string::size_type end,
+                              std::vector< Tokenized > &output) const
+{
+    Tokens token;
+    for (auto pos = begin; pos < end; ++pos)
+        if (matchToken(input, pos, token))
+            output.push_back(std::make_pair(token, pos));
+}
 
-        while ((pos = input.find(tokenString, pos)) != std::string::npos) {
-            Tokenized tmpToken = std::make_pair(token, pos);
-            tokenTree.insert(tmpToken);
-            ++pos; //search after found position
+bool Tokenizer::matchToken(const std::string &input,
+                           std::string::size_type pos,
+                           Tokens &token) const
+{
+    //"\r\n" is one newline, the check is local, so it works in chunks too
+    if (input[pos] == '\r' && pos + 1 < input.size() && input[pos + 1] == '\n') {
+        token = Tokens::newLine;
+        return true;
+    }
+    if (input[pos] == '\n' && pos > 0 && input[pos - 1] == '\r')
+        return false;
+
+    auto &candidates = firstCharTokens[ static_cast< unsigned char > (input[pos]) ];
+
+    for (auto candidate : candidates) {
+        auto &tokenString = tokenArray[ static_cast< std::size_t > (candidate) ];
+        if (input.compare(pos, tokenString.size(), tokenString) == 0) {
+            token = candidate;
+            return true;
         }
     }
-    return tokenTree;
+    return false;
 }
 
 void Tokenizer::removeBackslashes(std::string &input)
 {
-    std::string::size_type pos = 0;
+    //same as erasing each backslash with following char, but in one pass
+    joinedLines.clear();
+    removedBytes.clear();
+    std::string::size_type write = input.find('\\');
+    if (write == std::string::npos)
+        return;
 
-    while ((pos = input.find("\\", pos)) != std::string::npos) {
-        input.erase(pos, 2);
+    for (std::string::size_type read = write; read < input.size(); ++read) {
+        if (input[read] == '\\') {
+            ++read;
+            if (input.compare(read, 2, "\r\n") == 0)
+                ++read;
+            if (read < input.size() && input[read] == '\n')
+                joinedLines.push_back(write);
+            removedBytes.push_back(std::make_pair(write, std::min(read + 1, input.size()) - write));
+        }
+        else
+            input[write++] = input[read];
     }
+    input.resize(write);
+}
+
+void Tokenizer::tokenizeLazy(const std::string &input,
+                             std::vector< Tokenized > &output)
+{
+    //lines of original input, regions are visited in increasing order
+    std::string::size_type countedPos = 0;
+    unsigned countedLines = 1;
+    std::size_t joined = 0;
+    auto lineOf = [&](std::string::size_type pos) {
+        countedLines += std::count(input.begin() + countedPos, input.begin() + pos, '\n');
+        for (; joined < joinedLines.size() && joinedLines[joined] <= pos; ++joined)
+            ++countedLines;
+        countedPos = pos;
+        return countedLines;
+    };
+
+    //code before first doxygen comment is needed for header warnings
+    auto pos = findDoxygenBegin(input, 0);
+    tokenizeRange(input, std::min(byteOrderMarkLength(input), pos), std::min(pos, input.size()),
+                  output);
+
+    if (changedLines != nullptr) {
+        auto headerEnd = (pos < input.size()) ? input.find("*/", pos + 2) : input.size();
+        headerChanged = intersects(*changedLines, 1, lineOf(std::min(headerEnd, input.size())));
+    }
+
+    Tokens token;
+    bool header = true;
+    while (pos < input.size()) {
+        auto end = findSignatureEnd(input, pos);
+        auto next = findDoxygenBegin(input, end);
+
+        bool changed = header || changedLines == nullptr;
+        if (!changed) {
+            //lineOf has to be called in order
+            unsigned first = lineOf(pos);
+            changed = intersects(*changedLines, first, lineOf(end - 1));
+        }
+
+        if (changed) {
+            tokenizeRange(input, pos, end, output);
+
+            //parser steps over one token after the signature, so keep it
+            for (auto after = end; after < std::min(next, input.size()); ++after)
+                if (matchToken(input, after, token)) {
+                    output.push_back(std::make_pair(token, after));
+                    break;
+                }
+        }
+        header = false;
+        pos = next;
+    }
+}
+
+std::string::size_type Tokenizer::findDoxygenBegin(const std::string &input,
+                                                   std::string::size_type pos) const
+{
+    while ((pos = input.find_first_of("/\"'", pos)) != std::string::npos) {
+        if (input.compare(pos, 3, "/**") == 0)
+            return pos;
+        pos = skipLiteralOrComment(input, pos);
+    }
+    return std::string::npos;
+}
+
+std::string::size_type Tokenizer::findSignatureEnd(const std::string &input,
+                                                   std::string::size_type begin) const
+{
+    //comment end can share '*' with comment begin, same as in tokenizeRange
+    auto pos = input.find("*/", begin + 2);
+    if (pos == std::string::npos)
+        return input.size();
+    pos += 2;
+
+    int openParenthesisCounter = 0;
+    while ((pos = input.find_first_of("()/\"'", pos)) != std::string::npos) {
+        switch (input[pos]) {
+        case '(':
+            ++openParenthesisCounter;
+            ++pos;
+            break;
+        case ')':
+            ++pos;
+            if (openParenthesisCounter > 0 && --openParenthesisCounter == 0)
+                return pos;
+            break;
+        default:
+            if (input.compare(pos, 3, "/**") == 0)
+                return pos; //comment without function, next region starts here
+            pos = skipLiteralOrComment(input, pos);
+            break;
+        }
+    }
+    return input.size();
+}
+
+std::string::size_type Tokenizer::skipLiteralOrComment(const std::string &input,
+                                                       std::string::size_type pos) const
+{
+    std::string::size_type end = std::string::npos;
+
+    switch (input[pos]) {
+    case '"':
+        //escaped quotes were removed with backslashes
+        end = input.find('"', pos + 1);
+        if (end != std::string::npos)
+            ++end;
+        break;
+    case '\'':
+        //same as in parser, escaped char is removed, so 0 or 1 char
+        if (pos + 1 < input.size() && input[pos + 1] == '\'')
+            return pos + 2;
+        if (pos + 2 < input.size() && input[pos + 2] == '\'')
+            return pos + 3;
+        return pos + 1;
+    case '/':
+        if (input.compare(pos, 2, "//") == 0)
+            end = input.find('\n', pos);
+        else if (input.compare(pos, 2, "/*") == 0) {
+            end = input.find("*/", pos + 2);
+            if (end != std::string::npos)
+                end += 2;
+        }
+        else
+            return pos + 1;
+        break;
+    default:
+        return pos + 1;
+    }
+
+    return (end == std::string::npos) ? input.size() : end;
 }
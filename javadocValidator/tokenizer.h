@@ -12,8 +12,10 @@
 #include <array>
 #include <set>
 #include <tuple>
+#include <vector>
 #include <cstdint>
 
+#include "lines.h"
 
 enum class Tokens : std::uint8_t {
     all,
@@ -73,6 +75,24 @@ public:
     }
 };
 
+/**
+ * @brief byteOrderMarkLength length of UTF-8 byte order mark at the start of input
+ * @param input string created from given file
+ * @return 3 if input starts with byte order mark, else 0
+ */
+std::string::size_type byteOrderMarkLength(const std::string &input);
+
+/**
+ * @brief findInvalidUtf8 finds first byte, which is not part of valid UTF-8 sequence
+ *
+ * ASCII is skipped by 8 bytes at once, overlong forms, surrogates and code
+ * points above U+10FFFF are invalid
+ *
+ * @param input string created from given file
+ * @return position of invalid byte or npos
+ */
+std::string::size_type findInvalidUtf8(const std::string &input);
+
 class Tokenizer
 {
 public:
@@ -90,24 +110,201 @@ public:
      *
      * take input and finds tokens in it, which are saved in tokenTree
      * complexity is O(sizeof(input)*sizeof(Tokens))
+     * byte order mark is skipped and "\r\n" is one newLine token on '\r',
+     * so input is not rewritten for files from Windows
+     * big inputs are split into chunks, which are tokenized concurrently,
+     * the result is the same as of sequential run
+     * input without doxygen comment is rejected by prefilter, only its
+     * first tokens are returned, see setPrefilter
      *
      * @param input reference to string created from given file
      * @return tokenTree with structure of tokens
      */
     std::set<Tokenized, TokenizedComparator> tokenize(std::string &input);
 
+    /**
+     * @brief setLazy enables skipping of code, which is not validated
+     *
+     * in lazy mode are tokenized only the code before first doxygen
+     * comment and regions from doxygen comment to the end of following
+     * function signature, function bodies and undocumented code are skipped
+     * with respect to strings, chars and comments
+     *
+     * @param lazy true to enable lazy mode
+     */
+    void setLazy(bool lazy);
+
+    /**
+     * @brief setPrefilter enables fast reject of input without doxygen comment
+     *
+     * one scan decides, if input can contain doxygen comment. If it can not,
+     * only first two tokens (after parser merges whitespace) are returned,
+     * they are all parser needs for its "file with no doxygen" diagnostic.
+     * Warnings of parser filters after these tokens (e.g. about quotes) are
+     * then not reported, so it is disabled by default.
+     *
+     * @param prefilter true to enable prefilter
+     */
+    void setPrefilter(bool prefilter);
+
+    /**
+     * @brief setChangedLines restricts tokenization to changed documentation
+     *
+     * input is tokenized lazily (see setLazy) and from regions started by
+     * doxygen comment are kept only the ones with changed line. The first
+     * region is always kept, parser needs it as header.
+     * Regions are still found by one scan of whole input, only tokenizing
+     * and parsing are limited to changed ones.
+     *
+     * @param changedLines changed lines of input, nullptr to tokenize all regions
+     */
+    void setChangedLines(const LineRanges *changedLines);
+    /**
+     * @brief isHeaderChanged checks, if header has changed line
+     *
+     * header is the first doxygen comment with code before it, or whole
+     * input, if there is no doxygen comment
+     *
+     * @return true if last tokenized input has changed header or no changed lines were set
+     */
+    bool isHeaderChanged() const;
+    /**
+     * @brief originalOffset maps position in tokenized input to position in file
+     *
+     * tokenize removes backslashes with escaped characters, so positions differ
+     *
+     * @param pos position in last tokenized input
+     * @return position in input before tokenize
+     */
+    std::string::size_type originalOffset(std::string::size_type pos) const;
+
 private:
+    /**
+     * @brief minChunkSize inputs smaller than this are not split
+     */
+    static const std::string::size_type minChunkSize = 1 << 20;
+
     std::array< std::string, static_cast< std::size_t > (Tokens::NonterminalsCount) > tokenArray;
+    /**
+     * @brief firstCharTokens tokens starting with given character, in order of Tokens
+     */
+    std::array< std::vector< Tokens >, 256 > firstCharTokens;
     std::set< Tokenized, TokenizedComparator > tokenTree;
+    unsigned threads;
+    bool lazy;
+    bool prefilter;
+    const LineRanges *changedLines;
+    bool headerChanged;
+    /**
+     * @brief joinedLines positions, where removeBackslashes removed newline
+     *
+     * needed to count lines of original input
+     */
+    std::vector< std::string::size_type > joinedLines;
+    /**
+     * @brief removedBytes positions after removed backslash with count of all bytes removed before
+     */
+    std::vector< std::pair< std::string::size_type, std::string::size_type > > removedBytes;
+
+    /**
+     * @brief tokenizeRange finds tokens, which start in [begin, end)
+     *
+     * tokens may reach behind end, so neighbouring ranges overlap by
+     * length of the longest token, but each position is reported only
+     * by the range containing it. On one position is reported only
+     * the first token in order of Tokens (e.g. commentBegin and not cCommentBegin)
+     *
+     * @param input string created from given file
+     * @param begin first position to check
+     * @param end position after last position to check
+     * @param output found tokens are appended here, sorted by position
+     */
+    void tokenizeRange(const std::string &input,
+                       std::string::size_type begin,
+                       std::string::size_type end,
+                       std::vector< Tokenized > &output) const;
+    /**
+     * @brief matchToken finds token starting on given position
+     *
+     * '\n' of "\r\n" is not token, newLine is reported on '\r'
+     *
+     * @param input string created from given file
+     * @param pos position to check
+     * @param token found token, first one in order of Tokens
+     * @return true if some token starts on pos
+     */
+    bool matchToken(const std::string &input,
+                    std::string::size_type pos,
+                    Tokens &token) const;
     /**
      * @brief removeBackslashes remove all backslashes and next characters
      *
      * backslashes in C/C++ are parsed by preprocessor as escaped char
-     * we don't parse C/C++, so we can delete them with the next character
+     * we don't parse C/C++, so we can delete them with the next character,
+     * or with "\r\n" after them
      *
      * @param input reference to string, in which are '\' removed
      */
     void removeBackslashes(std::string &input);
+
+    /**
+     * @brief mayContainDoxygen checks, if input can contain doxygen comment
+     *
+     * called before removeBackslashes, input is checked as if they were removed
+     *
+     * @param input string created from given file
+     * @return false if there is no doxygen comment begin in input
+     */
+    bool mayContainDoxygen(const std::string &input) const;
+    /**
+     * @brief tokenizeLeading finds first two tokens, which are kept by parser filters
+     *
+     * merging of whitespace and erasing of comments is done same as in parser
+     *
+     * @param input string created from given file
+     * @param output found tokens
+     * @return false if the tokens depend on quotes, full tree is needed then
+     */
+    bool tokenizeLeading(const std::string &input,
+                         std::vector< Tokenized > &output) const;
+
+    /**
+     * @brief tokenizeLazy tokenizes only regions needed for validation
+     *
+     * regions without changed line are skipped, if changedLines are set
+     *
+     * @param input string created from given file
+     * @param output found tokens are appended here, sorted by position
+     */
+    void tokenizeLazy(const std::string &input, std::vector< Tokenized > &output);
+    /**
+     * @brief findDoxygenBegin finds next doxygen comment outside of strings, chars and comments
+     * @param input string created from given file
+     * @param pos position, where search starts (outside of string or comment)
+     * @return position of doxygen comment begin or npos
+     */
+    std::string::size_type findDoxygenBegin(const std::string &input,
+                                            std::string::size_type pos) const;
+    /**
+     * @brief findSignatureEnd finds end of region started by doxygen comment
+     *
+     * region ends after ')', which closes first '(' after the comment,
+     * or before next doxygen comment
+     *
+     * @param input string created from given file
+     * @param begin position of doxygen comment begin
+     * @return position after the region
+     */
+    std::string::size_type findSignatureEnd(const std::string &input,
+                                            std::string::size_type begin) const;
+    /**
+     * @brief skipLiteralOrComment steps over string, char or comment
+     * @param input string created from given file
+     * @param pos position of '"', '\'' or '/'
+     * @return position after string, char or comment, pos + 1 if there is none
+     */
+    std::string::size_type skipLiteralOrComment(const std::string &input,
+                                                std::string::size_type pos) const;
 };
 
 #endif // TOKENIZER_H
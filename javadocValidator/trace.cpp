@@ -0,0 +1,148 @@
+#include "trace.h"
+#include "json.h"
+
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+struct Event {
+    const char *name;
+    unsigned file;
+    std::int64_t begin;
+    std::int64_t end;
+    bool async;
+};
+
+struct ThreadBuffer {
+    unsigned tid;
+    unsigned file;
+    std::vector< Event > events;
+};
+
+//buffers are owned here, so they outlive threads of tokenizer and loader
+std::mutex registryMutex;
+std::vector< std::unique_ptr< ThreadBuffer > > buffers;
+std::map< std::string, unsigned > fileIds;
+std::vector< std::string > fileNames;
+
+thread_local ThreadBuffer *threadBuffer = nullptr;
+
+ThreadBuffer &getBuffer()
+{
+    if (threadBuffer == nullptr) {
+        std::lock_guard< std::mutex > lock(registryMutex);
+        buffers.emplace_back(new ThreadBuffer());
+        threadBuffer = buffers.back().get();
+        threadBuffer->tid = static_cast< unsigned >(buffers.size());
+        threadBuffer->file = 0;
+    }
+    return *threadBuffer;
+}
+
+unsigned getFileId(const std::string &fileName)
+{
+    std::lock_guard< std::mutex > lock(registryMutex);
+    auto ret = fileIds.insert(std::make_pair(fileName, fileNames.size() + 1));
+    if (ret.second)
+        fileNames.push_back(fileName);
+    return ret.first->second;
+}
+
+void writeCommon(std::ostream &out, const Event &event, pid_t pid, unsigned tid)
+{
+    out << "{\"name\":\"" << event.name << "\",\"cat\":\"validation\""
+        << ",\"pid\":" << pid << ",\"tid\":" << tid;
+    if (event.file > 0) {
+        out << ",\"args\":{\"file\":";
+        writeJsonString(out, fileNames[event.file - 1]);
+        out << "}";
+    }
+}
+
+} // namespace
+
+bool Trace::enabled = false;
+
+void Trace::enable()
+{
+    enabled = true;
+}
+
+void Trace::setFile(const std::string &fileName)
+{
+    if (!enabled)
+        return;
+    getBuffer().file = getFileId(fileName);
+}
+
+std::int64_t Trace::now()
+{
+    return std::chrono::duration_cast< std::chrono::nanoseconds >
+            (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::record(const char *name, std::int64_t begin, std::int64_t end)
+{
+    ThreadBuffer &buffer = getBuffer();
+    Event event = { name, buffer.file, begin, end, false };
+    buffer.events.push_back(event);
+}
+
+void Trace::recordAsync(const char *name, const std::string &fileName,
+                        std::int64_t begin, std::int64_t end)
+{
+    ThreadBuffer &buffer = getBuffer();
+    Event event = { name, getFileId(fileName), begin, end, true };
+    buffer.events.push_back(event);
+}
+
+bool Trace::write(const std::string &path)
+{
+    std::ofstream out(path);
+    if (!out.is_open())
+        return false;
+
+    std::lock_guard< std::mutex > lock(registryMutex);
+    pid_t pid = getpid();
+    std::uint64_t asyncId = 0;
+    bool first = true;
+
+    out << "{\"traceEvents\":[";
+    out.setf(std::ios_base::fixed);
+    out.precision(3);
+
+    for (auto &buffer : buffers) {
+        for (auto &event : buffer->events) {
+            double begin = event.begin / 1000.0;
+            double end = event.end / 1000.0;
+
+            if (!first)
+                out << ",";
+            first = false;
+            out << "\n";
+
+            if (!event.async) {
+                writeCommon(out, event, pid, buffer->tid);
+                out << ",\"ph\":\"X\",\"ts\":" << begin
+                    << ",\"dur\":" << (end - begin) << "}";
+                continue;
+            }
+
+            //async spans may overlap, so they are written as begin/end pair
+            ++asyncId;
+            writeCommon(out, event, pid, buffer->tid);
+            out << ",\"ph\":\"b\",\"id\":" << asyncId << ",\"ts\":" << begin << "},\n";
+            writeCommon(out, event, pid, buffer->tid);
+            out << ",\"ph\":\"e\",\"id\":" << asyncId << ",\"ts\":" << end << "}";
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return out.good();
+}
@@ -0,0 +1,102 @@
+/**
+  * @author Team A
+  * @file trace.h
+  *
+  * @brief spans of validation stages, exported as Chrome trace-event JSON
+  */
+#ifndef TRACE_H
+#define TRACE_H
+#include <string>
+#include <cstdint>
+
+class Trace
+{
+public:
+    /**
+     * @brief enable turns recording on, has to be called before other threads start
+     */
+    static void enable();
+    /**
+     * @brief isEnabled
+     * @return true if spans are recorded
+     */
+    static bool isEnabled() {
+        return enabled;
+    }
+
+    /**
+     * @brief setFile sets file, which is processed by calling thread
+     *
+     * following spans of the thread are tagged with this file
+     *
+     * @param fileName name of the file
+     */
+    static void setFile(const std::string &fileName);
+
+    /**
+     * @brief now current time for spans
+     * @return nanoseconds of steady clock
+     */
+    static std::int64_t now();
+
+    /**
+     * @brief record stores finished span of calling thread
+     *
+     * recording doesn't lock, each thread has its own buffer
+     *
+     * @param name name of span, has to be string literal
+     * @param begin start of span from now()
+     * @param end end of span from now()
+     */
+    static void record(const char *name, std::int64_t begin, std::int64_t end);
+    /**
+     * @brief recordAsync stores span, which overlaps with other spans of the thread
+     *
+     * used for requests processed by kernel, e.g. io_uring reads
+     *
+     * @param name name of span, has to be string literal
+     * @param fileName file of span
+     * @param begin start of span from now()
+     * @param end end of span from now()
+     */
+    static void recordAsync(const char *name, const std::string &fileName,
+                            std::int64_t begin, std::int64_t end);
+
+    /**
+     * @brief write writes all recorded spans as Chrome trace-event JSON
+     *
+     * all threads, which recorded spans, have to be finished or idle
+     *
+     * @param path path of output file
+     * @return false if file could not be written
+     */
+    static bool write(const std::string &path);
+
+private:
+    static bool enabled;
+};
+
+class TraceSpan
+{
+public:
+    /**
+     * @brief TraceSpan ctor - starts span, if tracing is enabled
+     * @param name name of span, has to be string literal
+     */
+    explicit TraceSpan(const char *name)
+        : name(name), begin(Trace::isEnabled() ? Trace::now() : 0) {
+    }
+    /**
+     * @brief ~TraceSpan dtor - records span
+     */
+    ~TraceSpan() {
+        if (Trace::isEnabled())
+            Trace::record(name, begin, Trace::now());
+    }
+
+private:
+    const char *name;
+    std::int64_t begin;
+};
+
+#endif // TRACE_H
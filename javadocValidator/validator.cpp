@@ -0,0 +1,143 @@
+#include "validator.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+#include "tokenizer.h"
+#include "parser.h"
+#include "trace.h"
+#include "perf.h"
+
+namespace {
+
+bool readBlocks(std::istream &input, std::string &content)
+{
+    char buffer[1 << 16];
+    content.clear();
+    while (input.read(buffer, sizeof(buffer)) || input.gcount() > 0)
+        content.append(buffer, static_cast< std::string::size_type >(input.gcount()));
+    return !input.bad();
+}
+
+} // namespace
+
+bool loadFile(const std::string &path, std::string &content)
+{
+    Trace::setFile(path);
+    TraceSpan span("load");
+    PerfSpan counters("load");
+
+    //standard input can't seek, so it is read in blocks
+    if (path == "-")
+        return readBlocks(std::cin, content);
+
+    std::ifstream input;
+    input.open(path, std::ios_base::in | std::ios_base::binary);
+    if (!input.is_open())
+        return false;
+
+    //read directly to the string, without copy through stringstream
+    input.seekg(0, std::ios_base::end);
+    auto size = input.tellg();
+    input.seekg(0, std::ios_base::beg);
+    if (size < 0) {
+        //pipe or other file without size
+        input.clear();
+        return readBlocks(input, content);
+    }
+
+    content.resize(static_cast< std::string::size_type >(size));
+    input.read(&content[0], size);
+    content.resize(static_cast< std::string::size_type >(input.gcount()));
+    input.close();
+    return true;
+}
+
+StreamStatus readStreamFile(std::istream &input, std::string &fileName, std::string &content)
+{
+    std::string header;
+    if (!std::getline(input, header))
+        return StreamStatus::end;
+
+    auto separator = header.find(' ');
+    if (separator == 0 || separator == std::string::npos
+        || header.find_first_not_of("0123456789") != separator
+        || separator + 1 == header.size())
+        return StreamStatus::malformed;
+
+    std::string::size_type length;
+    try {
+        length = std::stoull(header.substr(0, separator));
+    }
+    catch (const std::out_of_range &) {
+        return StreamStatus::malformed;
+    }
+    fileName = header.substr(separator + 1);
+
+    Trace::setFile(fileName);
+    TraceSpan span("load");
+    PerfSpan counters("load");
+
+    //content grows with read data, so wrong length doesn't allocate everything at once
+    content.clear();
+    while (content.size() < length) {
+        auto done = content.size();
+        auto block = std::min< std::string::size_type >(length - done, 1 << 20);
+        content.resize(done + block);
+        input.read(&content[done], static_cast< std::streamsize >(block));
+        if (static_cast< std::string::size_type >(input.gcount()) != block)
+            return StreamStatus::malformed;
+    }
+    return StreamStatus::file;
+}
+
+bool validate(std::string &input, const std::string &fileName,
+              const ValidationOptions &options, std::ostream &out)
+{
+    Trace::setFile(fileName);
+    TraceSpan span("validate");
+    PerfSpan counters("validate");
+    if (PerfCounters::isEnabled())
+        PerfCounters::addInput(input.size());
+
+    static const LineRanges noChanges;
+    const LineRanges *changedLines = nullptr;
+    if (options.diff != nullptr) {
+        changedLines = options.diff->find(fileName);
+        if (changedLines == nullptr)
+            changedLines = &noChanges;
+    }
+
+    //before tokenizer removes backslashes, so line is the one in file
+    auto invalid = findInvalidUtf8(input);
+    if (invalid != std::string::npos)
+        out << "Warning: invalid UTF-8 on line "
+            << std::count(input.begin(), input.begin() + invalid, '\n') + 1 << std::endl;
+
+    Tokenizer t;
+    t.setLazy(options.lazy);
+    t.setPrefilter(options.prefilter);
+    t.setChangedLines(changedLines);
+    auto tree = t.tokenize(input);
+    auto p = createParser(options.rules, input, fileName, out);
+    p->setCollectAll(options.collectAll, options.maxErrors);
+    p->setCheckHeader(t.isHeaderChanged());
+    p->initList(tree);
+
+    std::vector< DocFunction > functions;
+    if (options.extract != nullptr)
+        p->setExtract(&functions);
+    bool valid = p->parseFile();
+
+    if (options.extract != nullptr) {
+        for (auto &function : functions) {
+            function.comment.first = t.originalOffset(function.comment.first);
+            function.comment.second = t.originalOffset(function.comment.second);
+            function.signature.first = t.originalOffset(function.signature.first);
+            function.signature.second = t.originalOffset(function.signature.second);
+        }
+        writeDocFunctions(*options.extract, fileName, functions);
+    }
+    return valid;
+}
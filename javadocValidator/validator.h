@@ -0,0 +1,95 @@
+/**
+  * @author Team A
+  * @file validator.h
+  *
+  * @brief functions shared by all modes, which run the validation
+  */
+#ifndef VALIDATOR_H
+#define VALIDATOR_H
+#include <iostream>
+#include <string>
+
+#include "diff.h"
+#include "parser.h"
+
+/**
+ * @brief ValidationOptions options given on command line, which change validation
+ */
+struct ValidationOptions {
+    /**
+     * @brief lazy skip function bodies and undocumented code, see Tokenizer::setLazy
+     */
+    bool lazy = false;
+    /**
+     * @brief prefilter fast reject of files without doxygen, see Tokenizer::setPrefilter
+     */
+    bool prefilter = false;
+    /**
+     * @brief collectAll report all errors, see Parser::setCollectAll
+     */
+    bool collectAll = false;
+    /**
+     * @brief maxErrors limit of reported errors in collectAll mode, 0 = no limit
+     */
+    unsigned maxErrors = 100;
+    /**
+     * @brief diff only documentation with lines changed in diff is validated
+     */
+    const DiffIndex *diff = nullptr;
+    /**
+     * @brief rules mask of enabled checks, see Rule in parser.h
+     */
+    unsigned rules = allRules;
+    /**
+     * @brief extract documentation model of functions is written here as JSON Lines
+     */
+    std::ostream *extract = nullptr;
+};
+
+/**
+ * @brief loadFile reads whole file into string
+ * @param path path to the file, - for standard input
+ * @param content string, where the content of file is stored
+ * @return true if file was read, false if it could not be open
+ */
+bool loadFile(const std::string &path, std::string &content);
+
+/**
+ * @brief StreamStatus result of reading file from stream
+ */
+enum class StreamStatus {
+    file,
+    end,
+    malformed
+};
+
+/**
+ * @brief readStreamFile reads next file from length-prefixed stream
+ *
+ * each file in stream is line "<length> <fileName>" followed by
+ * length bytes of content, e.g. staged files written by pre-commit hook
+ *
+ * @param input stream with files
+ * @param fileName name of read file
+ * @param content content of read file
+ * @return file if file was read, end at the end of stream, malformed otherwise
+ */
+StreamStatus readStreamFile(std::istream &input, std::string &fileName, std::string &content);
+
+/**
+ * @brief validate runs tokenizer and parser on already loaded input
+ *
+ * input is modified by tokenizer (escaped characters are removed),
+ * invalid UTF-8 is reported as warning
+ *
+ * @param input content of the file
+ * @param fileName name expected in @file command of header
+ * @param options options of validation
+ * @param out stream, where warnings and errors are written
+ * @return true if input is valid, false otherwise
+ */
+bool validate(std::string &input, const std::string &fileName,
+              const ValidationOptions &options = ValidationOptions(),
+              std::ostream &out = std::cout);
+
+#endif // VALIDATOR_H
@@ -0,0 +1,162 @@
+#include "watcher.h"
+
+#include <iostream>
+#include <sstream>
+#include <cerrno>
+#include <cstring>
+
+#include <dirent.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+Watcher::Watcher(std::string directory, const ValidationOptions &options)
+    : directory(directory), options(options), inotifyFd(-1)
+{
+}
+
+Watcher::~Watcher()
+{
+    if (inotifyFd >= 0)
+        close(inotifyFd);
+}
+
+int Watcher::run()
+{
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) {
+        std::cout << "Error: inotify is not available: "
+                  << std::strerror(errno) << std::endl;
+        return -1;
+    }
+    //watch before first validation, so no change is missed
+    if (inotify_add_watch(inotifyFd, directory.c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO
+                          | IN_MOVED_FROM | IN_DELETE) < 0) {
+        std::cout << "Error: directory could not be watched: "
+                  << directory << std::endl;
+        return -1;
+    }
+
+    validateAll();
+    report();
+
+    pollfd pfd;
+    pfd.fd = inotifyFd;
+    pfd.events = POLLIN;
+
+    while (true) {
+        if (poll(&pfd, 1, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+
+        std::set< std::string > changed;
+        std::set< std::string > removed;
+        bool complete = readEvents(changed, removed);
+
+        //wait until burst of writes is over
+        while (poll(&pfd, 1, debounceMs) > 0)
+            complete = readEvents(changed, removed) && complete;
+
+        if (!complete) {
+            validateAll();
+        }
+        else {
+            for (auto &name : removed)
+                if (!changed.count(name))
+                    results.erase(name);
+            for (auto &name : changed)
+                revalidate(name);
+        }
+        report();
+    }
+}
+
+void Watcher::validateAll()
+{
+    results.clear();
+
+    DIR *dir = opendir(directory.c_str());
+    if (dir == nullptr)
+        return;
+
+    while (dirent *entry = readdir(dir)) {
+        std::string name(entry->d_name);
+        if (isSourceFile(name))
+            revalidate(name);
+    }
+    closedir(dir);
+}
+
+void Watcher::revalidate(const std::string &name)
+{
+    std::string input;
+    if (!loadFile(directory + "/" + name, input)) {
+        results.erase(name);
+        return;
+    }
+
+    std::ostringstream diagnostics;
+    Result &result = results[name];
+    //file name is checked without path, same as in single file mode
+    result.valid = validate(input, name, options, diagnostics);
+    result.diagnostics = diagnostics.str();
+}
+
+bool Watcher::readEvents(std::set< std::string > &changed,
+                         std::set< std::string > &removed)
+{
+    alignas(inotify_event) char buffer[4096];
+    bool complete = true;
+    ssize_t length;
+
+    while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+        for (char *ptr = buffer; ptr < buffer + length;) {
+            auto event = reinterpret_cast< inotify_event * >(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                complete = false;
+                continue;
+            }
+            if (event->len == 0 || !isSourceFile(event->name))
+                continue;
+
+            if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                changed.insert(event->name);
+            else
+                removed.insert(event->name);
+        }
+    }
+    return complete;
+}
+
+void Watcher::report()
+{
+    for (auto &result : results) {
+        std::cout << result.first << ":" << std::endl
+                  << result.second.diagnostics
+                  << (result.second.valid ? "Input is valid" : "Input is invalid")
+                  << std::endl << std::endl;
+    }
+    std::cout << "Watching " << directory << " (" << results.size()
+              << " files)" << std::endl;
+}
+
+bool Watcher::isSourceFile(const std::string &name)
+{
+    static const char *extensions[] = { ".c", ".h", ".cc", ".cpp", ".cxx",
+                                        ".hh", ".hpp", ".hxx" };
+
+    auto dot = name.find_last_of('.');
+    if (dot == std::string::npos || name[0] == '.')
+        return false;
+
+    std::string extension = name.substr(dot);
+    for (auto e : extensions)
+        if (extension == e)
+            return true;
+    return false;
+}
@@ -0,0 +1,86 @@
+/**
+  * @author Team A
+  * @file watcher.h
+  *
+  * @brief class Watcher revalidates files of directory, when they change
+  */
+#ifndef WATCHER_H
+#define WATCHER_H
+#include <string>
+#include <map>
+#include <set>
+
+#include "validator.h"
+
+class Watcher
+{
+public:
+    /**
+     * @brief Watcher ctor
+     * @param directory directory, whose files are validated
+     * @param options options used for each validation
+     */
+    Watcher(std::string directory, const ValidationOptions &options);
+    /**
+     * @brief ~Watcher dtor - closes inotify descriptor
+     */
+    ~Watcher();
+
+    /**
+     * @brief run validates all files once, then waits for changes
+     *
+     * uses inotify, only written or renamed files are validated again,
+     * results of other files are kept from previous runs
+     *
+     * @return -1 if directory could not be watched, otherwise runs forever
+     */
+    int run();
+
+private:
+    struct Result {
+        bool valid;
+        std::string diagnostics;
+    };
+
+    /**
+     * @brief debounceMs time without events, after which changes are handled
+     *
+     * editors usually write file in several steps, they are handled once
+     */
+    static const int debounceMs = 3;
+
+    std::string directory;
+    ValidationOptions options;
+    std::map< std::string, Result > results;
+    int inotifyFd;
+
+    /**
+     * @brief validateAll validates every source file in directory
+     */
+    void validateAll();
+    /**
+     * @brief revalidate validates one file and stores its result
+     * @param name name of file inside watched directory
+     */
+    void revalidate(const std::string &name);
+    /**
+     * @brief readEvents reads pending inotify events
+     * @param changed names of written or renamed files are added here
+     * @param removed names of deleted or moved out files are added here
+     * @return false if events were lost and whole directory has to be validated
+     */
+    bool readEvents(std::set< std::string > &changed,
+                    std::set< std::string > &removed);
+    /**
+     * @brief report prints results of all files
+     */
+    void report();
+    /**
+     * @brief isSourceFile checks, if file has extension of C/C++ source
+     * @param name name of file
+     * @return true for C/C++ source or header
+     */
+    static bool isSourceFile(const std::string &name);
+};
+
+#endif // WATCHER_H